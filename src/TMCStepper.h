@@ -26,10 +26,17 @@
 
 #if SW_CAPABLE_PLATFORM
 	#include <SoftwareSerial.h>
+
+	// Software serial pin sets available to the TMC2208Stepper constructors that take pins
+	#ifndef TMC_SW_SERIAL_PORTS
+		#define TMC_SW_SERIAL_PORTS 4
+	#endif
 #endif
 
 #include "source/SERIAL_SWITCH.h"
 #include "source/SW_SPI.h"
+#include "source/SPI_CHAIN.h"
+#include "source/UART_BUS.h"
 
 #pragma GCC diagnostic pop
 
@@ -40,6 +47,9 @@
 #include "source/TMC2208_bitfields.h"
 #include "source/TMC2209_bitfields.h"
 #include "source/TMC2660_bitfields.h"
+#include "source/TMC_REGISTERS.h"
+#include "source/TMC_CURRENT.h"
+#include "source/TMC_STATIC.h"
 
 #define INIT_REGISTER(REG) REG##_t REG##_register = REG##_t
 #define INIT2130_REGISTER(REG) TMC2130_n::REG##_t REG##_register = TMC2130_n::REG##_t
@@ -55,6 +65,20 @@
 
 class TMCStepper {
 	public:
+		/**
+		 *  Keeps the bus claimed for a sequence of register accesses.
+		 *  { TMCStepper::Session session(driver); driver.toff(4); driver.tbl(2); }
+		 */
+		class Session {
+			public:
+				explicit Session(TMCStepper &drv) : driver(drv) { driver.beginSession(); }
+				~Session() { driver.endSession(); }
+				Session(const Session&) = delete;
+				Session& operator=(const Session&) = delete;
+			private:
+				TMCStepper &driver;
+		};
+
 		uint16_t cs2rms(uint8_t CS);
 		void rms_current(uint16_t mA);
 		void rms_current(uint16_t mA, float mult);
@@ -63,6 +87,28 @@ class TMCStepper {
 		float hold_multiplier() { return holdMultiplier; }
 		uint8_t test_connection();
 
+		// Serve configuration getters from the shadow registers
+		void cache_mode(bool enable);
+		bool cache_mode() { return cache_enabled; }
+		void invalidate_cache();
+
+		// Defer register writes until commit()
+		void batch_mode(bool enable);
+		bool batch_mode() { return batch_enabled; }
+		void commit();
+
+		// Write every register kept in a shadow copy
+		void push();
+		// Only write registers not known to match the device
+		void push_changed();
+
+		// Register map, in ascending address order
+		uint8_t register_count() { return register_map().count; }
+		TMC_register_t register_info(uint8_t index);
+		bool find_register(uint8_t address, TMC_register_t &info);
+		void dump(uint32_t out[]);
+		uint8_t diff();
+
 		// Helper functions
 		void microsteps(uint16_t ms);
 		uint16_t microsteps();
@@ -76,6 +122,7 @@ class TMCStepper {
 		// R+WC: GSTAT
 		void 	GSTAT(							uint8_t input);
 		uint8_t GSTAT();
+		GSTAT_t gstat_snapshot();
 		bool 	reset();
 		bool 	drv_err();
 		bool 	uv_cp();
@@ -113,6 +160,7 @@ class TMCStepper {
 		TMCStepper(float RS) : Rsense(RS) {};
 		INIT_REGISTER(IHOLD_IRUN){{.sr=0}};	// 32b
 		INIT_REGISTER(TPOWERDOWN){.sr=0};		// 8b
+		bool reset_pending = false; // GSTAT.reset to be cleared by push_changed()
 		INIT_REGISTER(TPWMTHRS){.sr=0};			// 32b
 
 		static constexpr uint8_t TMC_READ = 0x00,
@@ -121,8 +169,11 @@ class TMCStepper {
 		struct TSTEP_t { constexpr static uint8_t address = 0x12; };
 		struct MSCNT_t { constexpr static uint8_t address = 0x6A; };
 
+		virtual void beginSession() {}
+		virtual void endSession() {}
 		virtual void write(uint8_t, uint32_t) = 0;
 		virtual uint32_t read(uint8_t) = 0;
+		virtual bool read_failed() { return false; } // Last read() returned no valid data
 		virtual void vsense(bool) = 0;
 		virtual bool vsense(void) = 0;
 		virtual uint32_t DRV_STATUS() = 0;
@@ -135,8 +186,53 @@ class TMCStepper {
 		virtual void tbl(uint8_t) = 0;
 		virtual uint8_t tbl() = 0;
 
+		// Shadow copy by address, false if the library keeps none
+		virtual bool shadow(uint8_t address, uint32_t &value);
+		virtual TMC_register_map_t register_map() = 0;
+		bool defer_write(uint8_t address);
+		bool dirty(uint8_t address) { return batch_enabled && get_flag(write_pending, address); }
+
+		void pushable(uint8_t select[]);
+		void write_shadows(const uint8_t select[]);
+		void current_scale(uint8_t CS);
+
+		// Flags hold one bit per register map entry, not per address
+		int8_t register_index(uint8_t address);
+		bool get_flag(const uint8_t flags[], uint8_t address);
+		void set_flag(uint8_t flags[], uint8_t address, bool value);
+
+		// Set while the device holds the shadow value
+		bool in_sync(uint8_t address) { return get_flag(synced, address); }
+		bool cached(uint8_t address) { return cache_enabled && in_sync(address); }
+		void cache_written(uint8_t address) { set_flag(synced, address, true); }
+		void reset_detected();
+
+		template<typename REG>
+		uint32_t read_cached(REG &reg) {
+			if (dirty(reg.address)) return reg.sr; // Not yet committed
+			if (!cache_enabled) return read(reg.address);
+			if (!cached(reg.address)) {
+				const uint32_t value = read(reg.address);
+				if (read_failed()) return reg.sr; // Keep the shadow, retry next time
+				reg.sr = value;
+				cache_written(reg.address);
+			}
+			return reg.sr;
+		}
+
+		// Bitfield setters, see field<> in TMC_REGISTERS.h
+		template<typename FIELD, typename REG>
+		void set_field(REG &reg, uint32_t value) {
+			reg.sr = (reg.sr & ~FIELD::mask) | ((value << FIELD::offset) & FIELD::mask);
+			write(FIELD::address, reg.sr);
+		}
+
 		const float Rsense;
 		float holdMultiplier = 0.5;
+		bool cache_enabled = false;
+		uint8_t synced[TMC_MAX_REGISTERS/8] = {0};
+		bool batch_enabled = false;
+		uint8_t write_pending[TMC_MAX_REGISTERS/8] = {0};
 };
 
 class TMC2130Stepper : public TMCStepper {
@@ -144,12 +240,19 @@ class TMC2130Stepper : public TMCStepper {
 		TMC2130Stepper(uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		TMC2130Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
 		TMC2130Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
+		TMC2130Stepper(SPIChain &chain, uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		void begin();
 		void defaults();
 		void setSPISpeed(uint32_t speed);
 		void switchCSpin(bool state);
 		bool isEnabled();
-		void push();
+
+		// Daisy chain, a driver without link index has a CS line of its own
+		int8_t chainLength() { return chain->links(link_index); }
+		void chain_read(uint8_t addressByte, uint32_t out[], SPI_STATUS_t status[] = nullptr);
+
+		// Pipelined reads: n registers in n+1 datagrams
+		void read_batch(const uint8_t addressBytes[], uint32_t out[], const uint8_t n);
 
 		// Helper functions
 		void sg_current_decrease(uint8_t value);
@@ -195,6 +298,7 @@ class TMC2130Stepper : public TMCStepper {
 
 		// R: IOIN
 		uint32_t IOIN();
+		IOIN_t ioin_snapshot();
 		bool step();
 		bool dir();
 		bool dcen_cfg4();
@@ -287,6 +391,7 @@ class TMC2130Stepper : public TMCStepper {
 
 		// R: DRV_STATUS
 		uint32_t DRV_STATUS();
+		TMC2130_n::DRV_STATUS_t drv_status_snapshot();
 		uint16_t sg_result();
 		bool fsactive();
 		uint8_t cs_actual();
@@ -329,15 +434,30 @@ class TMC2130Stepper : public TMCStepper {
 		// R: LOST_STEPS
 		uint32_t LOST_STEPS();
 
+		// SPI status of the last datagram
+		SPI_STATUS_t spi_status() { SPI_STATUS_t r{0}; r.sr = status_response; return r; }
+		bool reset_flag()   { return spi_status().reset_flag; }
+		bool driver_error() { return spi_status().driver_error; }
+		bool sg2()          { return spi_status().sg2; }
+		bool standstill()   { return spi_status().standstill; }
+
 		// Function aliases
 
-		uint8_t status_response;
+		uint8_t status_response = 0;
 
 	protected:
+		template<class, class> friend class TMCDriver;
+
 		void beginTransaction();
 		void endTransaction();
+		void beginSession();
+		void endSession();
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
 		uint8_t transfer(const uint8_t data);
-		void transferEmptyBytes(const uint8_t n);
+		void transfer(uint8_t *buf, const uint8_t count);
+		uint32_t transferDatagram(uint8_t addressByte, uint32_t config, uint8_t &status);
+		uint32_t transferFrame(uint8_t addressByte, uint32_t config = 0);
 		void write(uint8_t addressByte, uint32_t config);
 		uint32_t read(uint8_t addressByte);
 
@@ -349,7 +469,10 @@ class TMC2130Stepper : public TMCStepper {
 		INIT_REGISTER(CHOPCONF){{.sr=0}};	// 32b
 		INIT_REGISTER(COOLCONF){{.sr=0}};	// 32b
 		INIT_REGISTER(DCCTRL){{.sr = 0}};	// 32b
-		INIT_REGISTER(PWMCONF){{.sr=0}};	// 32b
+		union {	// Same register, TMC2160 and TMC5160 use the second layout
+			PWMCONF_t PWMCONF_register;	// 22b
+			TMC2160_n::PWMCONF_t PWMCONF_2160_register = TMC2160_n::PWMCONF_t{{.sr=0}};	// 32b
+		};
 		INIT_REGISTER(ENCM_CTRL){{.sr=0}};//  8b
 
 		struct IOINT_t 		{ constexpr static uint8_t address = 0x04; };
@@ -357,13 +480,14 @@ class TMC2130Stepper : public TMCStepper {
 		struct LOST_STEPS_t { constexpr static uint8_t address = 0x73; };
 		struct DRV_STATUS_t { constexpr static uint8_t address = 0X6F; };
 
-		static uint32_t spi_speed; // Default 2MHz
+		static SPIChain default_chain;
+		static SPIChain &software_chain(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK);
+		SPIChain * const chain;
 		const uint16_t _pinCS;
-		SW_SPIClass * TMC_SW_SPI = nullptr;
 		static constexpr float default_RS = 0.11;
 
 		int8_t link_index;
-		static int8_t chain_length;
+		uint8_t session_depth = 0;
 };
 
 class TMC2160Stepper : public TMC2130Stepper {
@@ -371,9 +495,9 @@ class TMC2160Stepper : public TMC2130Stepper {
 		TMC2160Stepper(uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		TMC2160Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
 		TMC2160Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
+		TMC2160Stepper(SPIChain &chain, uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		void begin();
 		void defaults();
-		void push();
 
 		uint16_t cs2rms(uint8_t CS);
 		void rms_current(uint16_t mA);
@@ -382,6 +506,7 @@ class TMC2160Stepper : public TMC2130Stepper {
 
 		// IOIN
 		uint32_t 	IOIN();
+		TMC2160_n::IOIN_t ioin_snapshot();
 		bool 			refl_step();
 		bool 			refr_dir();
 		bool 			encb_dcen_cfg4();
@@ -449,6 +574,7 @@ class TMC2160Stepper : public TMC2130Stepper {
 
 		// R: PWM_SCALE
 		uint32_t PWM_SCALE();
+		TMC2160_n::PWM_SCALE_t pwm_scale_snapshot();
 		uint8_t pwm_scale_sum();
 		uint16_t pwm_scale_auto();
 
@@ -457,10 +583,12 @@ class TMC2160Stepper : public TMC2130Stepper {
 		using TMC2130Stepper::pwm_ampl;
 		using TMC2130Stepper::pwm_symmetric;
 
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
+
 		INIT_REGISTER(SHORT_CONF){{.sr=0}};
 		INIT_REGISTER(DRV_CONF){{.sr=0}};
 		INIT_REGISTER(GLOBAL_SCALER){.sr=0};
-		INIT2160_REGISTER(PWMCONF){{.sr=0}};
 
 		static constexpr float default_RS = 0.075;
 };
@@ -470,10 +598,10 @@ class TMC5130Stepper : public TMC2160Stepper {
 		TMC5130Stepper(uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		TMC5130Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
 		TMC5130Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
+		TMC5130Stepper(SPIChain &chain, uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 
 		void begin();
 		void defaults();
-		void push();
 
 		void rms_current(uint16_t mA) { TMC2130Stepper::rms_current(mA); }
 		void rms_current(uint16_t mA, float mult) { TMC2130Stepper::rms_current(mA, mult); }
@@ -486,6 +614,7 @@ class TMC5130Stepper : public TMC2160Stepper {
 		void SLAVECONF(uint16_t input);
 		// R: IOIN
 		uint32_t 	IOIN();
+		TMC5130_n::IOIN_t ioin_snapshot();
 		bool 			refl_step();
 		bool 			refr_dir();
 		bool 			encb_dcen_cfg4();
@@ -531,6 +660,7 @@ class TMC5130Stepper : public TMC2160Stepper {
 
 		// R+C: RAMP_STAT
 		uint32_t RAMP_STAT();
+		RAMP_STAT_t ramp_stat_snapshot();
 		bool status_stop_l();
 		bool status_stop_r();
 		bool status_latch_l();
@@ -642,11 +772,13 @@ class TMC5130Stepper : public TMC2160Stepper {
 		using TMC2130Stepper::PWM_SCALE;
 
 	protected:
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
+
 		INIT_REGISTER(SLAVECONF){{.sr=0}};
 		INIT_REGISTER(OUTPUT){.sr=0};
 		INIT_REGISTER(X_COMPARE){.sr=0};
 		INIT_REGISTER(RAMPMODE){.sr=0};
-		INIT_REGISTER(XACTUAL){.sr=0};
 		INIT_REGISTER(VSTART){.sr=0};
 		INIT_REGISTER(A1){.sr=0};
 		INIT_REGISTER(V1){.sr=0};
@@ -714,12 +846,12 @@ class TMC5160Stepper : public TMC5130Stepper {
 		TMC5160Stepper(uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 		TMC5160Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
 		TMC5160Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1);
+		TMC5160Stepper(SPIChain &chain, uint16_t pinCS, float RS = default_RS, int8_t link_index = -1);
 
 		void rms_current(uint16_t mA) { TMC2160Stepper::rms_current(mA); }
 		void rms_current(uint16_t mA, float mult) { TMC2160Stepper::rms_current(mA, mult); }
 		uint16_t rms_current() { return TMC2160Stepper::rms_current(); }
 		void defaults();
-		void push();
 
 		// RW: GCONF
 		void recalibrate(bool);
@@ -764,6 +896,7 @@ class TMC5160Stepper : public TMC5130Stepper {
 
 		// R: PWM_AUTO
 		uint32_t PWM_AUTO();
+		PWM_AUTO_t pwm_auto_snapshot();
 		uint8_t pwm_ofs_auto();
 		uint8_t pwm_grad_auto();
 
@@ -798,6 +931,9 @@ class TMC5160Stepper : public TMC5130Stepper {
 		using TMC5130Stepper::vsense;
 		using TMC5130Stepper::rndtf;
 
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
+
 		INIT_REGISTER(ENC_DEVIATION){.sr=0};
 
 		static constexpr float default_RS = 0.075;
@@ -810,6 +946,8 @@ class TMC5161Stepper : public TMC5160Stepper {
 			TMC5160Stepper(pinCS, pinMOSI, pinMISO, pinSCK, link_index) {}
 		TMC5161Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link_index = -1) :
 			TMC5160Stepper(pinCS, RS, pinMOSI, pinMISO, pinSCK, link_index) {}
+		TMC5161Stepper(SPIChain &chain, uint16_t pinCS, float RS = default_RS, int8_t link_index = -1) :
+			TMC5160Stepper(chain, pinCS, RS, link_index) {}
 };
 
 class TMC2208Stepper : public TMCStepper {
@@ -830,8 +968,10 @@ class TMC2208Stepper : public TMCStepper {
 		#else
 			TMC2208Stepper(uint16_t, uint16_t, float) = delete; // Your platform does not currently support Software Serial
 		#endif
+		// The line state points into the object
+		TMC2208Stepper(const TMC2208Stepper&) = delete;
+		TMC2208Stepper& operator=(const TMC2208Stepper&) = delete;
 		void defaults();
-		void push();
 		void begin();
 		#if SW_CAPABLE_PLATFORM
 			void beginSerial(uint32_t baudrate) __attribute__((weak));
@@ -840,6 +980,39 @@ class TMC2208Stepper : public TMCStepper {
 		#endif
 		bool isEnabled();
 
+		// UART timing. Set the baud rate of a hardware port so that reply
+		// timeouts follow the wire time instead of the millisecond defaults.
+		// Timing belongs to the line, on a UARTBus it is shared by all drivers.
+		void baud_rate(uint32_t baud);
+		void reply_timeout(uint16_t us) { reply_timeout_us = us; } // 0 derives it from the baud rate
+		void frame_gap(uint16_t us) { line->frame_gap_us = us; }
+		void retries(uint8_t attempts) { max_retries = attempts ? attempts : 1; }
+
+		// Delay after the serial multiplexer switched to this driver
+		void mux_settle_time(uint16_t us) { if (sswitch != nullptr) sswitch->settle_time(us); }
+
+		// TX and RX joined on one wire, transmitted bytes are echoed back.
+		// Set for the whole bus when the driver is attached to a UARTBus.
+		void half_duplex(bool enable);
+		bool half_duplex() { return line->half_duplex; }
+
+		// Non-blocking register access through the UARTBus of the driver,
+		// constructed with TMC2208Stepper(UARTBus&, ...). Other drivers
+		// return false. Call poll() from the loop, or feed received bytes to
+		// receive() from the RX interrupt and poll() for timeouts and callbacks.
+		typedef UARTBus::Callback ReadCallback;
+		bool start_read(uint8_t addr, ReadCallback callback = nullptr);
+		bool start_write(uint8_t addr, uint32_t regVal);
+		bool poll();
+		void receive(uint8_t data);
+		bool busy() { return queued > 0 || (uart_bus != nullptr && uart_bus->active == this); }
+		uint32_t read_result() { return result; }
+
+		// Write without the reply delay, then check delivery with one IFCNT read
+		void fast_write_mode(bool enable);
+		bool fast_write_mode() { return fast_writes; }
+		bool verify_writes();
+
 		// RW: GCONF
 		void GCONF(uint32_t input);
 		void I_scale_analog(bool B);
@@ -879,6 +1052,7 @@ class TMC2208Stepper : public TMCStepper {
 
 		// R: IOIN
 		uint32_t IOIN();
+		TMC2208_n::IOIN_t ioin_snapshot();
 		bool enn();
 		bool ms1();
 		bool ms2();
@@ -927,6 +1101,7 @@ class TMC2208Stepper : public TMCStepper {
 
 		// R: DRV_STATUS
 		uint32_t DRV_STATUS();
+		TMC2208_n::DRV_STATUS_t drv_status_snapshot();
 		bool otpw();
 		bool ot();
 		bool s2ga();
@@ -965,11 +1140,13 @@ class TMC2208Stepper : public TMCStepper {
 
 		// R: PWM_SCALE
 		uint32_t PWM_SCALE();
+		TMC2208_n::PWM_SCALE_t pwm_scale_snapshot();
 		uint8_t pwm_scale_sum();
 		int16_t pwm_scale_auto();
 
 		// R: PWM_AUTO (0x72)
 		uint32_t PWM_AUTO();
+		PWM_AUTO_t pwm_auto_snapshot();
 		uint8_t pwm_ofs_auto();
 		uint8_t pwm_grad_auto();
 
@@ -977,6 +1154,10 @@ class TMC2208Stepper : public TMCStepper {
 		float Rsense = 0.11;
 		bool CRCerror = false;
 	protected:
+		bool read_failed() { return CRCerror; }
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
+
 		INIT2208_REGISTER(GCONF)			{{.sr=0}};
 		INIT_REGISTER(SLAVECONF)			{{.sr=0}};
 		INIT_REGISTER(FACTORY_CONF)		{{.sr=0}};
@@ -1006,25 +1187,56 @@ class TMC2208Stepper : public TMCStepper {
 		void preReadCommunication();
 		int16_t serial_read();
 		uint8_t serial_write(const uint8_t data);
+		size_t serial_write(const uint8_t *data, size_t length);
 		void postWriteCommunication();
 		void postReadCommunication();
 		void write(uint8_t, uint32_t);
 		uint32_t read(uint8_t);
+		void send_write(uint8_t addr, uint32_t regVal);
 		const uint8_t slave_address;
-		uint8_t calcCRC(uint8_t datagram[], uint8_t len);
+		static uint8_t calcCRC(uint8_t datagram[], uint8_t len);
+		static uint8_t crc_update(uint8_t crc, uint8_t data);
+		static uint8_t crc_result(uint8_t crc);
 		static constexpr uint8_t  TMC2208_SYNC = 0x05,
 															TMC2208_SLAVE_ADDR = 0x00;
-		static constexpr uint8_t replyDelay = 2;
-		static constexpr uint8_t abort_window = 5;
-		static constexpr uint8_t max_retries = 2;
+		// Datagrams with their CRC, shared with UARTBus and UARTDevice
+		static void write_datagram(uint8_t datagram[8], uint8_t slave, uint8_t addr, uint32_t value);
+		static void read_datagram(uint8_t datagram[4], uint8_t slave, uint8_t addr);
+		// Sync, master address 0xFF and register open every reply
+		static uint32_t reply_header(uint8_t addr) { return (uint32_t)TMC2208_SYNC << 16 | 0xFF00 | addr; }
+		// Reply of 8 bytes, the first in the top byte
+		static bool reply_valid(uint64_t reply);
+		uint16_t reply_timeout_us = 0;
+		uint8_t max_retries = 2;
+		uint16_t reply_time();
+		void wait_line(bool queue = false);
+		bool line_ready(bool queue = false);
+
+		UARTLine own_line;
+		UARTLine *line = &own_line;
+		void discard_input();
 
 		uint64_t _sendDatagram(uint8_t [], const uint8_t, uint16_t);
+
+		friend class UARTBus;
+		friend class UARTDevice;
+		template<class, class> friend class TMCDriver;
+		TMC2208Stepper(UARTBus &bus, float RS, uint8_t addr);
+		UARTBus *uart_bus = nullptr;
+		uint32_t result = 0; // Of the last read completed by the bus
+		uint8_t queued = 0; // Requests waiting in the queue of the bus
+
+		bool fast_writes = false;
+		uint8_t ifcnt_base = 0;
+		uint8_t writes_sent = 0;
 };
 
 class TMC2209Stepper : public TMC2208Stepper {
 	public:
 		TMC2209Stepper(Stream * SerialPort, float RS, uint8_t addr) :
 			TMC2208Stepper(SerialPort, RS, addr) {}
+		TMC2209Stepper(UARTBus &bus, float RS, uint8_t addr) :
+			TMC2208Stepper(bus, RS, addr) {}
 
 		#if SW_CAPABLE_PLATFORM
 			TMC2209Stepper(uint16_t SW_RX_pin, uint16_t SW_TX_pin, float RS, uint8_t addr) :
@@ -1032,10 +1244,10 @@ class TMC2209Stepper : public TMC2208Stepper {
 		#else
 			TMC2209Stepper(uint16_t, uint16_t, float, uint8_t) = delete; // Your platform does not currently support Software Serial
 		#endif
-		void push();
 
 		// R: IOIN
 		uint32_t IOIN();
+		TMC2209_n::IOIN_t ioin_snapshot();
 		bool enn();
 		bool ms1();
 		bool ms2();
@@ -1072,6 +1284,9 @@ class TMC2209Stepper : public TMC2208Stepper {
 		bool seimin();
 
 	protected:
+		bool shadow(uint8_t address, uint32_t &value);
+		TMC_register_map_t register_map();
+
 		INIT_REGISTER(TCOOLTHRS){.sr=0};
 		TMC2209_n::SGTHRS_t SGTHRS_register{.sr=0};
 		TMC2209_n::COOLCONF_t COOLCONF_register{{.sr=0}};
@@ -1080,6 +1295,7 @@ class TMC2209Stepper : public TMC2208Stepper {
 class TMC2224Stepper : public TMC2208Stepper {
 	public:
 		uint32_t IOIN();
+		TMC2224_n::IOIN_t ioin_snapshot();
 		bool enn();
 		bool ms1();
 		bool ms2();
@@ -1233,6 +1449,9 @@ class TMC2660Stepper {
 
 		uint8_t status_response;
 
+	protected:
+		void transfer(uint8_t *buf, const uint8_t count);
+
 	private:
 		INIT_REGISTER(DRVCTRL_1){{.sr=0}};
 		INIT_REGISTER(DRVCTRL_0){{.sr=0}};
@@ -1250,5 +1469,7 @@ class TMC2660Stepper {
 		float holdMultiplier = 0.5;
 		uint32_t spi_speed = 16000000/8; // Default 2MHz
 		uint8_t _savedToff = 0;
-		SW_SPIClass * TMC_SW_SPI = nullptr;
+		SW_SPIClass * const TMC_SW_SPI = nullptr;
+
+		static SW_SPIClass *software_spi(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK);
 };
@@ -1,33 +1,33 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-#define SET_REG(SETTING) CHOPCONF_register.SETTING = B; write(CHOPCONF_register.address, CHOPCONF_register.sr)
+#define SET_REG(OFFSET, WIDTH) WRITE_FIELD(CHOPCONF, OFFSET, WIDTH)
 
 // CHOPCONF
 uint32_t TMC2130Stepper::CHOPCONF() {
-	return read(CHOPCONF_register.address);
+	return read_cached(CHOPCONF_register);
 }
 void TMC2130Stepper::CHOPCONF(uint32_t input) {
 	CHOPCONF_register.sr = input;
 	write(CHOPCONF_register.address, CHOPCONF_register.sr);
 }
 
-void TMC2130Stepper::toff(		uint8_t B )	{ SET_REG(toff);	}
-void TMC2130Stepper::hstrt(		uint8_t B )	{ SET_REG(hstrt);	}
-void TMC2130Stepper::hend(		uint8_t B )	{ SET_REG(hend);	}
+void TMC2130Stepper::toff(		uint8_t B )	{ SET_REG(0, 4);	}
+void TMC2130Stepper::hstrt(		uint8_t B )	{ SET_REG(4, 3);	}
+void TMC2130Stepper::hend(		uint8_t B )	{ SET_REG(7, 4);	}
 //void TMC2130Stepper::fd(		uint8_t B )	{ SET_REG(fd);		}
-void TMC2130Stepper::disfdcc(	bool 	B )	{ SET_REG(disfdcc);	}
-void TMC2130Stepper::rndtf(		bool 	B )	{ SET_REG(rndtf);	}
-void TMC2130Stepper::chm(		bool 	B )	{ SET_REG(chm);		}
-void TMC2130Stepper::tbl(		uint8_t B )	{ SET_REG(tbl);		}
-void TMC2130Stepper::vsense(	bool 	B )	{ SET_REG(vsense);	}
-void TMC2130Stepper::vhighfs(	bool 	B )	{ SET_REG(vhighfs);	}
-void TMC2130Stepper::vhighchm(	bool 	B )	{ SET_REG(vhighchm);}
-void TMC2130Stepper::sync(		uint8_t B )	{ SET_REG(sync);	}
-void TMC2130Stepper::mres(		uint8_t B )	{ SET_REG(mres);	}
-void TMC2130Stepper::intpol(	bool 	B )	{ SET_REG(intpol);	}
-void TMC2130Stepper::dedge(		bool 	B )	{ SET_REG(dedge);	}
-void TMC2130Stepper::diss2g(	bool 	B )	{ SET_REG(diss2g);	}
+void TMC2130Stepper::disfdcc(	bool 	B )	{ SET_REG(12, 1);	}
+void TMC2130Stepper::rndtf(		bool 	B )	{ SET_REG(13, 1);	}
+void TMC2130Stepper::chm(		bool 	B )	{ SET_REG(14, 1);		}
+void TMC2130Stepper::tbl(		uint8_t B )	{ SET_REG(15, 2);		}
+void TMC2130Stepper::vsense(	bool 	B )	{ SET_REG(17, 1);	}
+void TMC2130Stepper::vhighfs(	bool 	B )	{ SET_REG(18, 1);	}
+void TMC2130Stepper::vhighchm(	bool 	B )	{ SET_REG(19, 1);}
+void TMC2130Stepper::sync(		uint8_t B )	{ SET_REG(20, 4);	}
+void TMC2130Stepper::mres(		uint8_t B )	{ SET_REG(24, 4);	}
+void TMC2130Stepper::intpol(	bool 	B )	{ SET_REG(28, 1);	}
+void TMC2130Stepper::dedge(		bool 	B )	{ SET_REG(29, 1);	}
+void TMC2130Stepper::diss2g(	bool 	B )	{ SET_REG(30, 1);	}
 
 uint8_t TMC2130Stepper::toff()		{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.toff;	}
 uint8_t TMC2130Stepper::hstrt()		{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.hstrt;	}
@@ -46,8 +46,8 @@ bool 	TMC2130Stepper::intpol()	{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.in
 bool 	TMC2130Stepper::dedge()		{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.dedge;	}
 bool 	TMC2130Stepper::diss2g()	{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.diss2g;	}
 
-void TMC5160Stepper::diss2vs(bool B){ SET_REG(diss2vs); }
-void TMC5160Stepper::tpfd(uint8_t B){ SET_REG(tpfd);	}
+void TMC5160Stepper::diss2vs(bool B){ SET_REG(31, 1); }
+void TMC5160Stepper::tpfd(uint8_t B){ SET_REG(20, 4);	}
 bool TMC5160Stepper::diss2vs()		{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.diss2vs; }
 uint8_t TMC5160Stepper::tpfd()		{ CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.tpfd;	}
 
@@ -56,18 +56,18 @@ void TMC2208Stepper::CHOPCONF(uint32_t input) {
 	write(CHOPCONF_register.address, CHOPCONF_register.sr);
 }
 uint32_t TMC2208Stepper::CHOPCONF() {
-	return read(CHOPCONF_register.address);
+	return read_cached(CHOPCONF_register);
 }
-void TMC2208Stepper::toff	( uint8_t  B )	{ SET_REG(toff); 	}
-void TMC2208Stepper::hstrt	( uint8_t  B )	{ SET_REG(hstrt); 	}
-void TMC2208Stepper::hend	( uint8_t  B )	{ SET_REG(hend); 	}
-void TMC2208Stepper::tbl	( uint8_t  B )	{ SET_REG(tbl); 	}
-void TMC2208Stepper::vsense	( bool     B )	{ SET_REG(vsense); 	}
-void TMC2208Stepper::mres	( uint8_t  B )	{ SET_REG(mres); 	}
-void TMC2208Stepper::intpol	( bool     B )	{ SET_REG(intpol); 	}
-void TMC2208Stepper::dedge	( bool     B )	{ SET_REG(dedge); 	}
-void TMC2208Stepper::diss2g	( bool     B )	{ SET_REG(diss2g); 	}
-void TMC2208Stepper::diss2vs( bool     B )	{ SET_REG(diss2vs); }
+void TMC2208Stepper::toff	( uint8_t  B )	{ SET_REG(0, 4); 	}
+void TMC2208Stepper::hstrt	( uint8_t  B )	{ SET_REG(4, 3); 	}
+void TMC2208Stepper::hend	( uint8_t  B )	{ SET_REG(7, 4); 	}
+void TMC2208Stepper::tbl	( uint8_t  B )	{ SET_REG(15, 2); 	}
+void TMC2208Stepper::vsense	( bool     B )	{ SET_REG(17, 1); 	}
+void TMC2208Stepper::mres	( uint8_t  B )	{ SET_REG(24, 4); 	}
+void TMC2208Stepper::intpol	( bool     B )	{ SET_REG(28, 1); 	}
+void TMC2208Stepper::dedge	( bool     B )	{ SET_REG(29, 1); 	}
+void TMC2208Stepper::diss2g	( bool     B )	{ SET_REG(30, 1); 	}
+void TMC2208Stepper::diss2vs( bool     B )	{ SET_REG(31, 1); }
 
 uint8_t TMC2208Stepper::toff()		{ TMC2208_n::CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.toff; 	}
 uint8_t TMC2208Stepper::hstrt()		{ TMC2208_n::CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.hstrt; 	}
@@ -80,6 +80,7 @@ bool 	TMC2208Stepper::dedge()		{ TMC2208_n::CHOPCONF_t r{0}; r.sr = CHOPCONF();
 bool 	TMC2208Stepper::diss2g()	{ TMC2208_n::CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.diss2g; 	}
 bool 	TMC2208Stepper::diss2vs()	{ TMC2208_n::CHOPCONF_t r{0}; r.sr = CHOPCONF(); return r.diss2vs; 	}
 
+#define SET_REG_2660(SETTING) CHOPCONF_register.SETTING = B; write(CHOPCONF_register.address, CHOPCONF_register.sr)
 #define GET_REG_2660(SETTING) return CHOPCONF_register.SETTING;
 
 uint32_t TMC2660Stepper::CHOPCONF() { return CHOPCONF_register.sr; }
@@ -89,15 +90,15 @@ void TMC2660Stepper::CHOPCONF(uint32_t data) {
 }
 
 void TMC2660Stepper::toff(uint8_t B) 	{
-	SET_REG(toff);
+	SET_REG_2660(toff);
 	if (B>0) _savedToff = B;
 }
-void TMC2660Stepper::hstrt(uint8_t B) 	{ SET_REG(hstrt); 	}
-void TMC2660Stepper::hend(uint8_t B) 	{ SET_REG(hend);	}
-void TMC2660Stepper::hdec(uint8_t B) 	{ SET_REG(hdec);	}
-void TMC2660Stepper::rndtf(bool B) 	{ SET_REG(rndtf);	}
-void TMC2660Stepper::chm(bool B) 	{ SET_REG(chm);	}
-void TMC2660Stepper::tbl(uint8_t B) 	{ SET_REG(tbl);	}
+void TMC2660Stepper::hstrt(uint8_t B) 	{ SET_REG_2660(hstrt); 	}
+void TMC2660Stepper::hend(uint8_t B) 	{ SET_REG_2660(hend);	}
+void TMC2660Stepper::hdec(uint8_t B) 	{ SET_REG_2660(hdec);	}
+void TMC2660Stepper::rndtf(bool B) 	{ SET_REG_2660(rndtf);	}
+void TMC2660Stepper::chm(bool B) 	{ SET_REG_2660(chm);	}
+void TMC2660Stepper::tbl(uint8_t B) 	{ SET_REG_2660(tbl);	}
 
 uint8_t TMC2660Stepper::toff() 	{ GET_REG_2660(toff);	}
 uint8_t TMC2660Stepper::hstrt() 	{ GET_REG_2660(hstrt);	}
@@ -1,7 +1,7 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-#define SET_REG(SETTING) COOLCONF_register.SETTING = B; write(COOLCONF_register.address, COOLCONF_register.sr);
+#define SET_REG(OFFSET, WIDTH) WRITE_FIELD(COOLCONF, OFFSET, WIDTH);
 #define GET_REG(SETTING) return COOLCONF_register.SETTING;
 
 // COOLCONF
@@ -11,13 +11,13 @@ void TMC2130Stepper::COOLCONF(uint32_t input) {
 	write(COOLCONF_register.address, COOLCONF_register.sr);
 }
 
-void TMC2130Stepper::semin(	uint8_t B )	{ SET_REG(semin);	}
-void TMC2130Stepper::seup(	uint8_t B )	{ SET_REG(seup);	}
-void TMC2130Stepper::semax(	uint8_t B )	{ SET_REG(semax);	}
-void TMC2130Stepper::sedn(	uint8_t B )	{ SET_REG(sedn);	}
-void TMC2130Stepper::seimin(bool 	B )	{ SET_REG(seimin);	}
-void TMC2130Stepper::sgt(	int8_t  B )	{ SET_REG(sgt);		}
-void TMC2130Stepper::sfilt(	bool 	B )	{ SET_REG(sfilt);	}
+void TMC2130Stepper::semin(	uint8_t B )	{ SET_REG(0, 4);	}
+void TMC2130Stepper::seup(	uint8_t B )	{ SET_REG(5, 2);	}
+void TMC2130Stepper::semax(	uint8_t B )	{ SET_REG(8, 4);	}
+void TMC2130Stepper::sedn(	uint8_t B )	{ SET_REG(13, 2);	}
+void TMC2130Stepper::seimin(bool 	B )	{ SET_REG(15, 1);	}
+void TMC2130Stepper::sgt(	int8_t  B )	{ SET_REG(16, 7);		}
+void TMC2130Stepper::sfilt(	bool 	B )	{ SET_REG(24, 1);	}
 
 uint8_t TMC2130Stepper::semin()	{ GET_REG(semin);	}
 uint8_t TMC2130Stepper::seup()	{ GET_REG(seup);	}
@@ -39,11 +39,11 @@ void TMC2209Stepper::COOLCONF(uint16_t input) {
 	write(COOLCONF_register.address, COOLCONF_register.sr);
 }
 
-void TMC2209Stepper::semin(	uint8_t B )	{ SET_REG(semin);	}
-void TMC2209Stepper::seup(	uint8_t B )	{ SET_REG(seup);	}
-void TMC2209Stepper::semax(	uint8_t B )	{ SET_REG(semax);	}
-void TMC2209Stepper::sedn(	uint8_t B )	{ SET_REG(sedn);	}
-void TMC2209Stepper::seimin(bool 	B )	{ SET_REG(seimin);	}
+void TMC2209Stepper::semin(	uint8_t B )	{ SET_REG(0, 4);	}
+void TMC2209Stepper::seup(	uint8_t B )	{ SET_REG(5, 2);	}
+void TMC2209Stepper::semax(	uint8_t B )	{ SET_REG(8, 4);	}
+void TMC2209Stepper::sedn(	uint8_t B )	{ SET_REG(13, 2);	}
+void TMC2209Stepper::seimin(bool 	B )	{ SET_REG(15, 1);	}
 
 uint8_t TMC2209Stepper::semin()	{ GET_REG(semin);	}
 uint8_t TMC2209Stepper::seup()	{ GET_REG(seup);	}
@@ -4,6 +4,7 @@
 #define GET_REG(NS, SETTING) NS::DRV_STATUS_t r{0}; r.sr = DRV_STATUS(); return r.SETTING
 
 uint32_t TMC2130Stepper::DRV_STATUS() { return read(DRV_STATUS_t::address); }
+TMC2130_n::DRV_STATUS_t TMC2130Stepper::drv_status_snapshot() { TMC2130_n::DRV_STATUS_t r{0}; r.sr = DRV_STATUS(); return r; }
 
 uint16_t TMC2130Stepper::sg_result(){ GET_REG(TMC2130_n, sg_result); 	}
 bool TMC2130Stepper::fsactive()		{ GET_REG(TMC2130_n, fsactive); 	}
@@ -20,6 +21,11 @@ bool TMC2130Stepper::stst()			{ GET_REG(TMC2130_n, stst); 		}
 uint32_t TMC2208Stepper::DRV_STATUS() {
 	return read(TMC2208_n::DRV_STATUS_t::address);
 }
+TMC2208_n::DRV_STATUS_t TMC2208Stepper::drv_status_snapshot() {
+	TMC2208_n::DRV_STATUS_t r{0};
+	r.sr = DRV_STATUS();
+	return r;
+}
 
 bool 		TMC2208Stepper::otpw()		{ GET_REG(TMC2208_n, otpw); 		}
 bool 		TMC2208Stepper::ot() 		{ GET_REG(TMC2208_n, ot); 	 		}
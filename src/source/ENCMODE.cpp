@@ -1,29 +1,29 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-#define SET_REG(SETTING) ENCMODE_register.SETTING = B; write(ENCMODE_register.address, ENCMODE_register.sr);
+#define SET_REG(OFFSET, WIDTH) WRITE_FIELD(ENCMODE, OFFSET, WIDTH);
 #define GET_REG(SETTING) ENCMODE_t r{0}; r.sr = ENCMODE(); return r.SETTING;
 
 // ENCMODE
 uint32_t TMC5130Stepper::ENCMODE() {
-	return read(ENCMODE_register.address);
+	return read_cached(ENCMODE_register);
 }
 void TMC5130Stepper::ENCMODE(uint32_t input) {
 	ENCMODE_register.sr = input;
 	write(ENCMODE_register.address, ENCMODE_register.sr);
 }
 
-void TMC5130Stepper::pol_a(bool B)			{ SET_REG(pol_a);			}
-void TMC5130Stepper::pol_b(bool B)			{ SET_REG(pol_b);			}
-void TMC5130Stepper::pol_n(bool B)			{ SET_REG(pol_n);			}
-void TMC5130Stepper::ignore_ab(bool B)		{ SET_REG(ignore_ab);		}
-void TMC5130Stepper::clr_cont(bool B)		{ SET_REG(clr_cont);		}
-void TMC5130Stepper::clr_once(bool B)		{ SET_REG(clr_once);		}
-void TMC5130Stepper::pos_edge(bool B)		{ SET_REG(pos_edge);		}
-void TMC5130Stepper::neg_edge(bool B)		{ SET_REG(neg_edge);		}
-void TMC5130Stepper::clr_enc_x(bool B)		{ SET_REG(clr_enc_x);		}
-void TMC5130Stepper::latch_x_act(bool B)	{ SET_REG(latch_x_act);		}
-void TMC5130Stepper::enc_sel_decimal(bool B){ SET_REG(enc_sel_decimal);	}
+void TMC5130Stepper::pol_a(bool B)			{ SET_REG(0, 1);			}
+void TMC5130Stepper::pol_b(bool B)			{ SET_REG(1, 1);			}
+void TMC5130Stepper::pol_n(bool B)			{ SET_REG(2, 1);			}
+void TMC5130Stepper::ignore_ab(bool B)		{ SET_REG(3, 1);		}
+void TMC5130Stepper::clr_cont(bool B)		{ SET_REG(4, 1);		}
+void TMC5130Stepper::clr_once(bool B)		{ SET_REG(5, 1);		}
+void TMC5130Stepper::pos_edge(bool B)		{ SET_REG(6, 1);		}
+void TMC5130Stepper::neg_edge(bool B)		{ SET_REG(7, 1);		}
+void TMC5130Stepper::clr_enc_x(bool B)		{ SET_REG(8, 1);		}
+void TMC5130Stepper::latch_x_act(bool B)	{ SET_REG(9, 1);		}
+void TMC5130Stepper::enc_sel_decimal(bool B){ SET_REG(10, 1);	}
 
 bool TMC5130Stepper::pol_a()			{ GET_REG(pol_a);			}
 bool TMC5130Stepper::pol_b()			{ GET_REG(pol_b);			}
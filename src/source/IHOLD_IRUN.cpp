@@ -1,7 +1,7 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-#define SET_REG(SETTING) IHOLD_IRUN_register.SETTING = B; write(IHOLD_IRUN_register.address, IHOLD_IRUN_register.sr);
+#define SET_REG(OFFSET, WIDTH) WRITE_FIELD(IHOLD_IRUN, OFFSET, WIDTH);
 #define GET_REG(SETTING) return IHOLD_IRUN_register.SETTING;
 
 // IHOLD_IRUN
@@ -11,9 +11,9 @@ void TMCStepper::IHOLD_IRUN(uint32_t input) {
 	write(IHOLD_IRUN_register.address, IHOLD_IRUN_register.sr);
 }
 
-void 	TMCStepper::ihold(uint8_t B) 		{ SET_REG(ihold);		}
-void 	TMCStepper::irun(uint8_t B)  		{ SET_REG(irun); 		}
-void 	TMCStepper::iholddelay(uint8_t B)	{ SET_REG(iholddelay); 	}
+void 	TMCStepper::ihold(uint8_t B) 		{ SET_REG(0, 5);		}
+void 	TMCStepper::irun(uint8_t B)  		{ SET_REG(8, 5); 		}
+void 	TMCStepper::iholddelay(uint8_t B)	{ SET_REG(16, 4); 	}
 
 uint8_t TMCStepper::ihold() 				{ GET_REG(ihold);		}
 uint8_t TMCStepper::irun()  				{ GET_REG(irun); 		}
@@ -6,6 +6,11 @@
 uint32_t TMC5130Stepper::RAMP_STAT() {
 	return read(RAMP_STAT_t::address);
 }
+RAMP_STAT_t TMC5130Stepper::ramp_stat_snapshot() {
+	RAMP_STAT_t r{0};
+	r.sr = RAMP_STAT();
+	return r;
+}
 
 bool TMC5130Stepper::status_stop_l()		{ GET_REG(status_stop_l);		}
 bool TMC5130Stepper::status_stop_r()		{ GET_REG(status_stop_r);		}
@@ -1,15 +1,58 @@
 #include "SERIAL_SWITCH.h"
+#include <new>
 
 SSwitch::SSwitch( const uint16_t pin1, const uint16_t pin2, const uint8_t address) :
   p1(pin1),
   p2(pin2),
-  addr(address)
+  addr(address),
+  next(first)
 	{
 		pinMode(pin1, OUTPUT);		
     pinMode(pin2, OUTPUT);
+    first = this;
 	}
 
+SSwitch::~SSwitch() {
+  for (SSwitch **s = &first; *s != nullptr; s = &(*s)->next) {
+    if (*s == this) {
+      *s = next;
+      break;
+    }
+  }
+}
+
+SSwitch *SSwitch::first = nullptr;
+
+/**
+ *  Drivers on the same channel share one switch. Switches not yet known
+ *  are constructed in a static pool instead of on the heap.
+ */
+SSwitch *SSwitch::channel(const uint16_t pin1, const uint16_t pin2, const uint8_t address) {
+  alignas(SSwitch) static uint8_t pool[TMC_SERIAL_SWITCHES][sizeof(SSwitch)];
+  static uint8_t used = 0;
+
+  for (SSwitch *s = first; s != nullptr; s = s->next) {
+    if (s->p1 == pin1 && s->p2 == pin2 && s->addr == address) return s;
+  }
+  if (used == TMC_SERIAL_SWITCHES) return nullptr;
+  return new (pool[used++]) SSwitch(pin1, pin2, address);
+}
+
+/**
+ *  Points the multiplexer at this channel. Nothing is written while it is
+ *  still selected, so back to back datagrams to one driver go out directly.
+ *  The settle time is only spent after an actual switch.
+ */
 void SSwitch::active() {
+  if (selected) return;
+
   digitalWrite(p1, addr & 0b01 ? HIGH : LOW);
   digitalWrite(p2, addr & 0b10 ? HIGH : LOW);
+
+  for (SSwitch *s = first; s != nullptr; s = s->next) {
+    if (s->p1 == p1 && s->p2 == p2) s->selected = false;
+  }
+  selected = true;
+
+  if (settle_us) delayMicroseconds(settle_us);
 }
@@ -9,12 +9,31 @@
 
 #include "TMC_platforms.h"
 
+// Multiplexer channels available to the TMC2208Stepper constructor that takes them
+#ifndef TMC_SERIAL_SWITCHES
+	#define TMC_SERIAL_SWITCHES 4
+#endif
+
 class SSwitch {
   public:
     SSwitch(const uint16_t pin1, const uint16_t pin2, const uint8_t address);
+    ~SSwitch();
+    // Linked into the list of all switches
+    SSwitch(const SSwitch&) = delete;
+    SSwitch& operator=(const SSwitch&) = delete;
+    // Switch of this channel, nullptr once all TMC_SERIAL_SWITCHES are taken
+    static SSwitch *channel(const uint16_t pin1, const uint16_t pin2, const uint8_t address);
     void active();
+    bool is_active() { return selected; }
+    void settle_time(uint16_t us) { settle_us = us; }
   private:
     const uint16_t p1;
     const uint16_t p2;
     const uint8_t addr;
+    uint16_t settle_us = 0;
+    bool selected = false;
+
+    // All switches, to find the ones sharing a multiplexer
+    static SSwitch *first;
+    SSwitch *next = nullptr;
 };
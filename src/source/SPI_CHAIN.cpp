@@ -0,0 +1,101 @@
+#include "TMCStepper.h"
+#include "SPI_CHAIN.h"
+#include <new>
+
+/**
+ *  Drivers given the same pins share one chain, so a daisy chain built
+ *  with the pin constructors counts all of its links. The chains are
+ *  constructed in a static pool instead of on the heap.
+ */
+SPIChain *SPIChain::software(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) {
+	alignas(SPIChain) static uint8_t pool[TMC_SW_SPI_CHAINS][sizeof(SPIChain)];
+	static uint8_t used = 0;
+
+	for (uint8_t i = 0; i < used; i++) {
+		SPIChain *chain = reinterpret_cast<SPIChain*>(pool[i]);
+		if (chain->sw_spi.same_pins(pinMOSI, pinMISO, pinSCK)) return chain;
+	}
+	if (used == TMC_SW_SPI_CHAINS) return nullptr;
+	return new (pool[used++]) SPIChain(pinMOSI, pinMISO, pinSCK);
+}
+
+void SPIChain::beginTransaction() {
+	if (TMC_SW_SPI == nullptr)
+		spi->beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
+}
+
+void SPIChain::endTransaction() {
+	if (TMC_SW_SPI == nullptr)
+		spi->endTransaction();
+}
+
+void SPIChain::transfer(uint8_t *buf, const uint8_t count) {
+	if (TMC_SW_SPI != nullptr) {
+		for (uint8_t i = 0; i < count; i++) buf[i] = TMC_SW_SPI->transfer(buf[i]);
+	}
+	else {
+		spi->transfer(buf, count);
+	}
+}
+
+void SPIChain::pack(uint8_t buf[5], uint8_t addressByte, uint32_t data) {
+	buf[0] = addressByte;
+	buf[1] = data >> 24;
+	buf[2] = data >> 16;
+	buf[3] = data >> 8;
+	buf[4] = data;
+}
+
+uint32_t SPIChain::unpack(const uint8_t buf[5]) {
+	return (uint32_t)buf[1] << 24 | (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 8 | buf[4];
+}
+
+SPIDevice::SPIDevice(SPIChain &spi_chain, uint16_t pinCS, int8_t link) :
+	chain(&spi_chain),
+	_pinCS(pinCS),
+	link_index(link)
+	{
+		chain->attach(link);
+	}
+
+void SPIDevice::begin() {
+	pinMode(_pinCS, OUTPUT);
+	digitalWrite(_pinCS, HIGH);
+	if (chain->TMC_SW_SPI != nullptr) chain->TMC_SW_SPI->init();
+}
+
+void SPIDevice::write(uint8_t address, uint32_t value) {
+	chain->beginTransaction();
+	transferFrame(address | 0x80, value);
+	chain->endTransaction();
+}
+
+// The response to a read arrives with the following datagram
+uint32_t SPIDevice::read(uint8_t address) {
+	chain->beginTransaction();
+	transferFrame(address);
+	const uint32_t out = transferFrame(address);
+	chain->endTransaction();
+	return out;
+}
+
+// Same framing as TMC2130Stepper::transferFrame()
+uint32_t SPIDevice::transferFrame(uint8_t addressByte, uint32_t data) {
+	const int8_t links = chain->links(link_index);
+	const int8_t slot = chain->slot(link_index);
+	uint32_t out = 0;
+
+	digitalWrite(_pinCS, LOW);
+	for (int8_t i = 0; i < links; i++) {
+		uint8_t buf[5];
+		SPIChain::pack(buf, i == slot ? addressByte : 0, i == slot ? data : 0);
+		chain->transfer(buf, 5);
+		if (i == slot) {
+			status_response = buf[0];
+			out = SPIChain::unpack(buf);
+		}
+	}
+	digitalWrite(_pinCS, HIGH);
+
+	return out;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#include <SPI.h>
+#elif defined(bcm2835)
+#include "source/rpi_bcm2835.h"
+#include "source/bcm2835_spi.h"
+#include "source/bcm2835_stream.h"
+#endif
+
+#include "SW_SPI.h"
+
+// Software SPI pin sets available to the constructors that take pins
+#ifndef TMC_SW_SPI_CHAINS
+	#define TMC_SW_SPI_CHAINS 2
+#endif
+
+/**
+ *  One SPI bus or CS-separated daisy chain.
+ *  Holds the clock rate and bus used by all drivers attached to it,
+ *  and the number of links that a frame has to be shifted through.
+ */
+class SPIChain {
+	public:
+		constexpr SPIChain(SPIClass &bus, uint32_t speed = 16000000/8) :
+			spi(&bus),
+			spi_speed(speed)
+			{}
+		constexpr SPIChain(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) :
+			sw_spi(pinMOSI, pinMISO, pinSCK),
+			TMC_SW_SPI(&sw_spi)
+			{}
+		// Drivers keep a pointer to their chain
+		SPIChain(const SPIChain&) = delete;
+		SPIChain& operator=(const SPIChain&) = delete;
+
+		// Chain of the software SPI bus on these pins, nullptr once all
+		// TMC_SW_SPI_CHAINS are taken
+		static SPIChain *software(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK);
+
+		void setSPISpeed(uint32_t speed) { spi_speed = speed; }
+		uint32_t getSPISpeed() { return spi_speed; }
+		void length(int8_t links) { chain_length = links; }
+		int8_t length() { return chain_length > 0 ? chain_length : 1; }
+		void attach(int8_t link_index) {
+			if (link_index > chain_length)
+				chain_length = link_index;
+		}
+
+	protected:
+		friend class TMC2130Stepper;
+		friend class TMC2160Stepper;
+		friend class SPIDevice;
+		friend class TMC2660Stepper;
+
+		// Datagrams per frame for the driver at link_index (-1 if not chained)
+		int8_t links(int8_t link_index) { return link_index > 0 ? length() : 1; }
+		// Our datagram and our response share the same slot in the frame
+		int8_t slot(int8_t link_index) { return links(link_index) - (link_index > 0 ? link_index : 1); }
+
+		void beginTransaction();
+		void endTransaction();
+		// The received bytes replace the sent ones in buf
+		void transfer(uint8_t *buf, const uint8_t count);
+
+		// 40 bit datagram: address byte, then the data MSB first
+		static void pack(uint8_t buf[5], uint8_t addressByte, uint32_t data);
+		static uint32_t unpack(const uint8_t buf[5]);
+
+		SPIClass * const spi = nullptr;
+		SW_SPIClass sw_spi = SW_SPIClass(0, 0, 0);
+		SW_SPIClass * const TMC_SW_SPI = nullptr;
+		uint32_t spi_speed = 16000000/8; // Default 2MHz
+		int8_t chain_length = 0;
+};
+
+/**
+ *  Register access to one driver of an SPIChain, without shadow registers
+ *  or virtual calls. Serves as the bus of the TMCDriver front end.
+ */
+class SPIDevice {
+	public:
+		SPIDevice(SPIChain &spi_chain, uint16_t pinCS, int8_t link = -1);
+
+		void begin();
+		void write(uint8_t address, uint32_t value);
+		uint32_t read(uint8_t address);
+		// Status byte of the last datagram
+		uint8_t status() { return status_response; }
+
+	protected:
+		uint32_t transferFrame(uint8_t addressByte, uint32_t data = 0);
+
+		SPIChain * const chain;
+		const uint16_t _pinCS;
+		const int8_t link_index;
+		uint8_t status_response = 0;
+};
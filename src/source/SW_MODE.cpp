@@ -1,30 +1,30 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-#define SET_REG(SETTING) SW_MODE_register.SETTING = B; write(SW_MODE_register.address, SW_MODE_register.sr)
+#define SET_REG(OFFSET, WIDTH) WRITE_FIELD(SW_MODE, OFFSET, WIDTH)
 #define GET_REG(SETTING) SW_MODE_t r{0}; r.sr = SW_MODE(); return r.SETTING
 
 // SW_MODE
 uint32_t TMC5130Stepper::SW_MODE() {
-	return read(SW_MODE_register.address);
+	return read_cached(SW_MODE_register);
 }
 void TMC5130Stepper::SW_MODE(uint32_t input) {
 	SW_MODE_register.sr = input;
 	write(SW_MODE_register.address, SW_MODE_register.sr);
 }
 
-void TMC5130Stepper::stop_l_enable(bool B)		{ SET_REG(stop_l_enable);	}
-void TMC5130Stepper::stop_r_enable(bool B)		{ SET_REG(stop_r_enable);	}
-void TMC5130Stepper::pol_stop_l(bool B)			{ SET_REG(pol_stop_l);		}
-void TMC5130Stepper::pol_stop_r(bool B)			{ SET_REG(pol_stop_r);		}
-void TMC5130Stepper::swap_lr(bool B)			{ SET_REG(swap_lr);			}
-void TMC5130Stepper::latch_l_active(bool B)		{ SET_REG(latch_l_active);	}
-void TMC5130Stepper::latch_l_inactive(bool B)	{ SET_REG(latch_l_inactive);}
-void TMC5130Stepper::latch_r_active(bool B)		{ SET_REG(latch_r_active);	}
-void TMC5130Stepper::latch_r_inactive(bool B)	{ SET_REG(latch_r_inactive);}
-void TMC5130Stepper::en_latch_encoder(bool B)	{ SET_REG(en_latch_encoder);}
-void TMC5130Stepper::sg_stop(bool B)			{ SET_REG(sg_stop);			}
-void TMC5130Stepper::en_softstop(bool B)		{ SET_REG(en_softstop);		}
+void TMC5130Stepper::stop_l_enable(bool B)		{ SET_REG(0, 1);	}
+void TMC5130Stepper::stop_r_enable(bool B)		{ SET_REG(1, 1);	}
+void TMC5130Stepper::pol_stop_l(bool B)			{ SET_REG(2, 1);		}
+void TMC5130Stepper::pol_stop_r(bool B)			{ SET_REG(3, 1);		}
+void TMC5130Stepper::swap_lr(bool B)			{ SET_REG(4, 1);			}
+void TMC5130Stepper::latch_l_active(bool B)		{ SET_REG(5, 1);	}
+void TMC5130Stepper::latch_l_inactive(bool B)	{ SET_REG(6, 1);}
+void TMC5130Stepper::latch_r_active(bool B)		{ SET_REG(7, 1);	}
+void TMC5130Stepper::latch_r_inactive(bool B)	{ SET_REG(8, 1);}
+void TMC5130Stepper::en_latch_encoder(bool B)	{ SET_REG(9, 1);}
+void TMC5130Stepper::sg_stop(bool B)			{ SET_REG(10, 1);			}
+void TMC5130Stepper::en_softstop(bool B)		{ SET_REG(11, 1);		}
 
 bool TMC5130Stepper::stop_r_enable()			{ GET_REG(stop_r_enable);	}
 bool TMC5130Stepper::pol_stop_l()				{ GET_REG(pol_stop_l);		}
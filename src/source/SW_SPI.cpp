@@ -1,11 +1,5 @@
 #include "SW_SPI.h"
 
-SW_SPIClass::SW_SPIClass(uint16_t mosi, uint16_t miso, uint16_t sck) :
-  mosi_pin(mosi),
-  miso_pin(miso),
-  sck_pin(sck)
-  {}
-
 void SW_SPIClass::init() {
   pinMode(mosi_pin, OUTPUT);
   pinMode(sck_pin, OUTPUT);
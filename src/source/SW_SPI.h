@@ -12,23 +12,30 @@
 
 class SW_SPIClass {
 	public:
-		SW_SPIClass(uint16_t sw_mosi_pin, uint16_t sw_miso_pin, uint16_t sw_sck_pin);
+		constexpr SW_SPIClass(uint16_t sw_mosi_pin, uint16_t sw_miso_pin, uint16_t sw_sck_pin) :
+			mosi_pin(sw_mosi_pin),
+			miso_pin(sw_miso_pin),
+			sck_pin(sw_sck_pin)
+			{}
 		void init();
 		void begin() {};
 		uint8_t transfer(uint8_t ulVal);
 		uint16_t transfer16(uint16_t data);
 		void endTransaction() {};
+		bool same_pins(uint16_t sw_mosi_pin, uint16_t sw_miso_pin, uint16_t sw_sck_pin) const {
+			return mosi_pin == sw_mosi_pin && miso_pin == sw_miso_pin && sck_pin == sw_sck_pin;
+		}
 	private:
-		const uint16_t	mosi_pin,
-						miso_pin,
-						sck_pin;
+		uint16_t	mosi_pin,
+					miso_pin,
+					sck_pin;
 
 		#if defined(ARDUINO_ARCH_AVR)
-			fastio_bm mosi_bm,
-					miso_bm,
-					sck_bm;
-			fastio_reg mosi_register,
-							 miso_register,
-							 sck_register;
+			fastio_bm mosi_bm = 0,
+					miso_bm = 0,
+					sck_bm = 0;
+			fastio_reg mosi_register = nullptr,
+							 miso_register = nullptr,
+							 sck_register = nullptr;
 		#endif
 };
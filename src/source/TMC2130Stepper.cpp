@@ -1,44 +1,35 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 
-int8_t TMC2130Stepper::chain_length = 0;
-uint32_t TMC2130Stepper::spi_speed = 16000000/8;
+SPIChain TMC2130Stepper::default_chain(SPI);
 
 TMC2130Stepper::TMC2130Stepper(uint16_t pinCS, float RS, int8_t link) :
-  TMCStepper(RS),
-  _pinCS(pinCS),
-  link_index(link)
-  {
-    defaults();
-
-    if (link > chain_length)
-      chain_length = link;
-  }
+  TMC2130Stepper(default_chain, pinCS, RS, link)
+  {}
 
 TMC2130Stepper::TMC2130Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link) :
-  TMCStepper(default_RS),
-  _pinCS(pinCS),
-  link_index(link)
-  {
-    SW_SPIClass *SW_SPI_Obj = new SW_SPIClass(pinMOSI, pinMISO, pinSCK);
-    TMC_SW_SPI = SW_SPI_Obj;
-    defaults();
-
-    if (link > chain_length)
-      chain_length = link;
-  }
+  TMC2130Stepper(pinCS, default_RS, pinMOSI, pinMISO, pinSCK, link)
+  {}
 
 TMC2130Stepper::TMC2130Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link) :
+  TMC2130Stepper(software_chain(pinMOSI, pinMISO, pinSCK), pinCS, RS, link)
+  {}
+
+// Shared by all drivers on these pins. With every software chain taken
+// the driver falls back to the hardware SPI chain.
+SPIChain &TMC2130Stepper::software_chain(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) {
+  SPIChain *sw_chain = SPIChain::software(pinMOSI, pinMISO, pinSCK);
+  return sw_chain != nullptr ? *sw_chain : default_chain;
+}
+
+TMC2130Stepper::TMC2130Stepper(SPIChain &spi_chain, uint16_t pinCS, float RS, int8_t link) :
   TMCStepper(RS),
+  chain(&spi_chain),
   _pinCS(pinCS),
   link_index(link)
   {
-    SW_SPIClass *SW_SPI_Obj = new SW_SPIClass(pinMOSI, pinMISO, pinSCK);
-    TMC_SW_SPI = SW_SPI_Obj;
     defaults();
-
-    if (link > chain_length)
-      chain_length = link;
+    chain->attach(link);
   }
 
 void TMC2130Stepper::defaults() {
@@ -56,7 +47,7 @@ void TMC2130Stepper::defaults() {
 
 __attribute__((weak))
 void TMC2130Stepper::setSPISpeed(uint32_t speed) {
-  spi_speed = speed;
+  chain->setSPISpeed(speed);
 }
 
 __attribute__((weak))
@@ -66,99 +57,155 @@ void TMC2130Stepper::switchCSpin(bool state) {
 
 __attribute__((weak))
 void TMC2130Stepper::beginTransaction() {
-  if (TMC_SW_SPI == nullptr) {
-    SPI.beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
-  }
+  chain->beginTransaction();
 }
 __attribute__((weak))
 void TMC2130Stepper::endTransaction() {
-  if (TMC_SW_SPI == nullptr) {
-    SPI.endTransaction();
-  }
+  chain->endTransaction();
+}
+
+/**
+ *  The bus is claimed once for the outermost session and
+ *  released when that session ends.
+ */
+void TMC2130Stepper::beginSession() {
+  if (session_depth++ == 0)
+    beginTransaction();
+}
+void TMC2130Stepper::endSession() {
+  if (session_depth > 0 && --session_depth == 0)
+    endTransaction();
 }
 
 __attribute__((weak))
 uint8_t TMC2130Stepper::transfer(const uint8_t data) {
   uint8_t out = 0;
-  if (TMC_SW_SPI != nullptr) {
-    out = TMC_SW_SPI->transfer(data);
+  if (chain->TMC_SW_SPI != nullptr) {
+    out = chain->TMC_SW_SPI->transfer(data);
   }
   else {
-    out = SPI.transfer(data);
+    out = chain->spi->transfer(data);
   }
   return out;
 }
 
-void TMC2130Stepper::transferEmptyBytes(const uint8_t n) {
-  for (uint8_t i = 0; i < n; i++) {
-    transfer(0x00);
-  }
+/**
+ *  Block transfer of a whole datagram. All driver traffic goes through
+ *  here, so override this when replacing the SPI backend, e.g. to use DMA.
+ *  The received bytes replace the sent ones in buf.
+ */
+__attribute__((weak))
+void TMC2130Stepper::transfer(uint8_t *buf, const uint8_t count) {
+  chain->transfer(buf, count);
+}
+
+uint32_t TMC2130Stepper::transferDatagram(uint8_t addressByte, uint32_t config, uint8_t &status) {
+  uint8_t buf[5];
+  SPIChain::pack(buf, addressByte, config);
+  transfer(buf, 5);
+
+  status = buf[0];
+  return SPIChain::unpack(buf);
 }
 
 __attribute__((weak))
 uint32_t TMC2130Stepper::read(uint8_t addressByte) {
   uint32_t out = 0UL;
-  int8_t i = 1;
 
-  beginTransaction();
+  beginSession();
+  transferFrame(addressByte);
+  out = transferFrame(addressByte); // Send the address byte again
+  endSession();
+
+  return out;
+}
+
+/**
+ *  Read the same register from every driver in the chain using two CS frames.
+ *  out[] and the optional status[] must hold chainLength() values and are
+ *  indexed by link_index-1.
+ */
+void TMC2130Stepper::chain_read(uint8_t addressByte, uint32_t out[], SPI_STATUS_t status[]) {
+  const int8_t links = chainLength();
+
+  beginSession();
   switchCSpin(LOW);
-  transfer(addressByte);
-  // Clear SPI
-  transferEmptyBytes(4);
-
-  // Shift the written data to the correct driver in chain
-  // Default link_index = -1 and no shifting happens
-  while(i < link_index) {
-    transferEmptyBytes(5);
-    i++;
+  uint8_t link_status = 0;
+  // Every link receives the read request
+  for (int8_t i = 0; i < links; i++) {
+    transferDatagram(addressByte, 0, link_status);
   }
 
   switchCSpin(HIGH);
   switchCSpin(LOW);
 
-  // Shift data from target link into the last one...
-  while(i < chain_length) {
-    transferEmptyBytes(5);
-    i++;
+  // Responses come out starting from the last link in the chain
+  for (int8_t i = links; i > 0; i--) {
+    const uint32_t data = transferDatagram(0x00, 0, link_status);
+
+    if (i == link_index || links == 1) status_response = link_status;
+    if (status != nullptr) status[i-1].sr = link_status;
+    out[i-1] = data;
   }
 
-  // ...and once more to MCU
-  status_response = transfer(addressByte); // Send the address byte again
-  out  = transfer(0x00);
-  out <<= 8;
-  out |= transfer(0x00);
-  out <<= 8;
-  out |= transfer(0x00);
-  out <<= 8;
-  out |= transfer(0x00);
-
-  endTransaction();
+  endSession();
   switchCSpin(HIGH);
+}
+
+/**
+ *  Clock one frame through the whole chain. Our link gets the datagram,
+ *  the other links get an empty read.
+ *  Returns the response of our link to the previous frame.
+ */
+uint32_t TMC2130Stepper::transferFrame(uint8_t addressByte, uint32_t config) {
+  const int8_t links = chainLength();
+  const int8_t slot = chain->slot(link_index);
+  uint32_t out = 0UL;
+  uint8_t status = 0;
+
+  switchCSpin(LOW);
+  for (int8_t i = 0; i < links; i++) {
+    if (i != slot) {
+      transferDatagram(0x00, 0, status);
+      continue;
+    }
+    out = transferDatagram(addressByte, config, status);
+    SPI_STATUS_t latest{0};
+    latest.sr = status;
+    if (latest.reset_flag && !spi_status().reset_flag) reset_detected();
+    status_response = status;
+  }
+  switchCSpin(HIGH);
+
   return out;
 }
 
+/**
+ *  Read n registers making use of the response being delayed by one datagram.
+ *  Each frame requests the next register while returning the previous one.
+ */
+void TMC2130Stepper::read_batch(const uint8_t addressBytes[], uint32_t out[], const uint8_t n) {
+  if (!n) return;
+
+  beginSession();
+  transferFrame(addressBytes[0]);
+  for (uint8_t i = 1; i < n; i++) {
+    out[i-1] = transferFrame(addressBytes[i]);
+  }
+  // Last response is pushed out with a harmless GCONF read
+  out[n-1] = transferFrame(TMC_READ | GCONF_t::address);
+  endSession();
+}
+
 __attribute__((weak))
 void TMC2130Stepper::write(uint8_t addressByte, uint32_t config) {
+  if (defer_write(addressByte)) return;
   addressByte |= TMC_WRITE;
-  int8_t i = 1;
 
-  beginTransaction();
-  switchCSpin(LOW);
-  status_response = transfer(addressByte);
-  transfer(config>>24);
-  transfer(config>>16);
-  transfer(config>>8);
-  transfer(config);
-
-  // Shift the written data to the correct driver in chain
-  // Default link_index = -1 and no shifting happens
-  while(i < link_index) {
-    transferEmptyBytes(5);
-    i++;
-  }
-
-  endTransaction();
-  switchCSpin(HIGH);
+  beginSession();
+  transferFrame(addressByte, config);
+  endSession();
+  cache_written(addressByte & ~TMC_WRITE);
 }
 
 void TMC2130Stepper::begin() {
@@ -166,7 +213,9 @@ void TMC2130Stepper::begin() {
   pinMode(_pinCS, OUTPUT);
   switchCSpin(HIGH);
 
-  if (TMC_SW_SPI != nullptr) TMC_SW_SPI->init();
+  if (chain->TMC_SW_SPI != nullptr) chain->TMC_SW_SPI->init();
+
+  Session session(*this);
 
   GCONF(GCONF_register.sr);
   CHOPCONF(CHOPCONF_register.sr);
@@ -184,25 +233,63 @@ void TMC2130Stepper::begin() {
 
 bool TMC2130Stepper::isEnabled() { return !drv_enn_cfg6() && toff(); }
 
-void TMC2130Stepper::push() {
-  GCONF(GCONF_register.sr);
-  IHOLD_IRUN(IHOLD_IRUN_register.sr);
-  TPOWERDOWN(TPOWERDOWN_register.sr);
-  TPWMTHRS(TPWMTHRS_register.sr);
-  TCOOLTHRS(TCOOLTHRS_register.sr);
-  THIGH(THIGH_register.sr);
-  XDIRECT(XDIRECT_register.sr);
-  VDCMIN(VDCMIN_register.sr);
-  CHOPCONF(CHOPCONF_register.sr);
-  COOLCONF(COOLCONF_register.sr);
-  DCCTRL(DCCTRL_register.sr);
-  PWMCONF(PWMCONF_register.sr);
-  ENCM_CTRL(ENCM_CTRL_register.sr);
+bool TMC2130Stepper::shadow(uint8_t address, uint32_t &value) {
+  switch(address) {
+    SHADOW_REG(GCONF);
+    SHADOW_REG(TCOOLTHRS);
+    SHADOW_REG(THIGH);
+    SHADOW_REG(XDIRECT);
+    SHADOW_REG(VDCMIN);
+    SHADOW_REG(CHOPCONF);
+    SHADOW_REG(COOLCONF);
+    SHADOW_REG(DCCTRL);
+    SHADOW_REG(PWMCONF);
+    SHADOW_REG(ENCM_CTRL);
+  }
+  return TMCStepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC2130_registers[] REGISTER_MAP_STORAGE = {
+  { 0x00, 18, TMC_access::RW,                 0x00000000 }, // GCONF
+  { 0x01,  3, TMC_access::RC | TMC_access::V, 0x00000000 }, // GSTAT
+  { 0x04, 32, TMC_access::R | TMC_access::V,  0x00000000 }, // IOIN
+  { 0x10, 20, TMC_access::W,                  0x00000000 }, // IHOLD_IRUN
+  { 0x11,  8, TMC_access::W,                  0x00000000 }, // TPOWERDOWN
+  { 0x12, 20, TMC_access::R | TMC_access::V,  0x00000000 }, // TSTEP
+  { 0x13, 20, TMC_access::W,                  0x00000000 }, // TPWMTHRS
+  { 0x14, 20, TMC_access::W,                  0x00000000 }, // TCOOLTHRS
+  { 0x15, 20, TMC_access::W,                  0x00000000 }, // THIGH
+  { 0x2D, 32, TMC_access::RW,                 0x00000000 }, // XDIRECT
+  { 0x33, 23, TMC_access::W,                  0x00000000 }, // VDCMIN
+  { 0x60, 32, TMC_access::W,                  0xAAAAB554 }, // MSLUT0
+  { 0x61, 32, TMC_access::W,                  0x4A9554AA }, // MSLUT1
+  { 0x62, 32, TMC_access::W,                  0x24492929 }, // MSLUT2
+  { 0x63, 32, TMC_access::W,                  0x10104222 }, // MSLUT3
+  { 0x64, 32, TMC_access::W,                  0xFBFFFFFF }, // MSLUT4
+  { 0x65, 32, TMC_access::W,                  0xB5BB777D }, // MSLUT5
+  { 0x66, 32, TMC_access::W,                  0x49295556 }, // MSLUT6
+  { 0x67, 32, TMC_access::W,                  0x00404222 }, // MSLUT7
+  { 0x68, 32, TMC_access::W,                  0xFFFF8056 }, // MSLUTSEL
+  { 0x69, 24, TMC_access::W,                  0x00F70000 }, // MSLUTSTART
+  { 0x6A, 10, TMC_access::R | TMC_access::V,  0x00000000 }, // MSCNT
+  { 0x6B, 25, TMC_access::R | TMC_access::V,  0x00000000 }, // MSCURACT
+  { 0x6C, 32, TMC_access::RW,                 0x00000000 }, // CHOPCONF
+  { 0x6D, 25, TMC_access::W,                  0x00000000 }, // COOLCONF
+  { 0x6E, 24, TMC_access::W,                  0x00000000 }, // DCCTRL
+  { 0x6F, 32, TMC_access::R | TMC_access::V,  0x00000000 }, // DRV_STATUS
+  { 0x70, 22, TMC_access::W,                  0x00050480 }, // PWMCONF
+  { 0x71,  8, TMC_access::R | TMC_access::V,  0x00000000 }, // PWM_SCALE
+  { 0x72,  2, TMC_access::W,                  0x00000000 }, // ENCM_CTRL
+  { 0x73, 20, TMC_access::R | TMC_access::V,  0x00000000 }, // LOST_STEPS
+};
+
+TMC_register_map_t TMC2130Stepper::register_map() { return REGISTER_MAP(TMC2130_registers); }
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // R: IOIN
 uint32_t  TMC2130Stepper::IOIN()    { return read(IOIN_t::address); }
+IOIN_t    TMC2130Stepper::ioin_snapshot() { IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool TMC2130Stepper::step()         { IOIN_t r{0}; r.sr = IOIN(); return r.step; }
 bool TMC2130Stepper::dir()          { IOIN_t r{0}; r.sr = IOIN(); return r.dir; }
 bool TMC2130Stepper::dcen_cfg4()    { IOIN_t r{0}; r.sr = IOIN(); return r.dcen_cfg4; }
@@ -227,14 +314,14 @@ void TMC2130Stepper::THIGH(uint32_t input) {
 ///////////////////////////////////////////////////////////////////////////////////////
 // RW: XDIRECT
 uint32_t TMC2130Stepper::XDIRECT() {
-  return read(XDIRECT_register.address);
+  return read_cached(XDIRECT_register);
 }
 void TMC2130Stepper::XDIRECT(uint32_t input) {
   XDIRECT_register.sr = input;
   write(XDIRECT_register.address, XDIRECT_register.sr);
 }
-void TMC2130Stepper::coil_A(int16_t B)  { XDIRECT_register.coil_A = B; write(XDIRECT_register.address, XDIRECT_register.sr); }
-void TMC2130Stepper::coil_B(int16_t B)  { XDIRECT_register.coil_B = B; write(XDIRECT_register.address, XDIRECT_register.sr); }
+void TMC2130Stepper::coil_A(int16_t B)  { WRITE_FIELD(XDIRECT, 0, 9); }
+void TMC2130Stepper::coil_B(int16_t B)  { WRITE_FIELD(XDIRECT, 16, 9); }
 int16_t TMC2130Stepper::coil_A()        { XDIRECT_t r{0}; r.sr = XDIRECT(); return r.coil_A; }
 int16_t TMC2130Stepper::coil_B()        { XDIRECT_t r{0}; r.sr = XDIRECT(); return r.coil_B; }
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -260,7 +347,7 @@ void TMC2130Stepper::dc_sg(uint8_t input) {
 }
 
 uint32_t TMC2130Stepper::DCCTRL() {
-	return read(DCCTRL_register.address);
+	return read_cached(DCCTRL_register);
 }
 uint16_t TMC2130Stepper::dc_time() {
 	DCCTRL_t r{0};
@@ -282,8 +369,8 @@ void TMC2130Stepper::ENCM_CTRL(uint8_t input) {
   ENCM_CTRL_register.sr = input;
   write(ENCM_CTRL_register.address, ENCM_CTRL_register.sr);
 }
-void TMC2130Stepper::inv(bool B)      { ENCM_CTRL_register.inv = B;       write(ENCM_CTRL_register.address, ENCM_CTRL_register.sr); }
-void TMC2130Stepper::maxspeed(bool B) { ENCM_CTRL_register.maxspeed  = B; write(ENCM_CTRL_register.address, ENCM_CTRL_register.sr); }
+void TMC2130Stepper::inv(bool B)      { WRITE_FIELD(ENCM_CTRL, 0, 1); }
+void TMC2130Stepper::maxspeed(bool B) { WRITE_FIELD(ENCM_CTRL, 1, 1); }
 bool TMC2130Stepper::inv()            { return ENCM_CTRL_register.inv; }
 bool TMC2130Stepper::maxspeed()       { return ENCM_CTRL_register.maxspeed; }
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -64,6 +64,23 @@ struct GSTAT_t {
   };
 };
 
+// Status byte returned with every SPI datagram
+struct SPI_STATUS_t {
+  union {
+    uint8_t sr : 8;
+    struct {
+      bool  reset_flag : 1,
+            driver_error : 1,
+            sg2 : 1,
+            standstill : 1,
+            velocity_reached : 1, // 5130, 5160
+            position_reached : 1, // 5130, 5160
+            status_stop_l : 1, // 5130, 5160
+            status_stop_r : 1; // 5130, 5160
+    };
+  };
+};
+
 struct IOIN_t {
   constexpr static uint8_t address = 0x04;
   union {
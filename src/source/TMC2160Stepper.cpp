@@ -9,18 +9,23 @@ TMC2160Stepper::TMC2160Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint1
 TMC2160Stepper::TMC2160Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link) :
   TMC2130Stepper(pinCS, default_RS, pinMOSI, pinMISO, pinSCK, link)
   { defaults(); }
+TMC2160Stepper::TMC2160Stepper(SPIChain &chain, uint16_t pinCS, float RS, int8_t link) :
+  TMC2130Stepper(chain, pinCS, RS, link)
+  { defaults(); }
 
 void TMC2160Stepper::begin() {
   //set pins
   pinMode(_pinCS, OUTPUT);
   switchCSpin(HIGH);
 
-  if (TMC_SW_SPI != nullptr) TMC_SW_SPI->init();
+  if (chain->TMC_SW_SPI != nullptr) chain->TMC_SW_SPI->init();
+
+  Session session(*this);
 
   GCONF(GCONF_register.sr);
   CHOPCONF(CHOPCONF_register.sr);
   COOLCONF(COOLCONF_register.sr);
-  PWMCONF(PWMCONF_register.sr);
+  PWMCONF(PWMCONF_2160_register.sr);
   IHOLD_IRUN(IHOLD_IRUN_register.sr);
 
   toff(8); //off_time(8);
@@ -50,7 +55,7 @@ void TMC2160Stepper::defaults() {
   //MSLUTSTART_register.start_sin = 0;
   //MSLUTSTART_register.start_sin90 = 247;
   CHOPCONF_register.sr = 0x10410150;
-  PWMCONF_register.sr = 0xC40C001E;
+  PWMCONF_2160_register.sr = 0xC40C001E;
 }
 
 /*
@@ -64,10 +69,10 @@ void TMC2160Stepper::defaults() {
                            (CS + 1) * V_fs               | V_fs = 0.325
 
 */
-void TMC2160Stepper::rms_current(uint16_t mA) {
+uint8_t TMC_current::scaled_cs(uint16_t mA, float Rsense, uint8_t &scaler) {
   constexpr uint32_t V_fs = 325; // 0.325 * 1000
   uint8_t CS = 31;
-  uint32_t scaler = 0; // = 256
+  uint32_t result = 0; // = 256
 
   const uint16_t RS_scaled = Rsense * 0xFFFF; // Scale to 16b
   uint32_t numerator = 11585; // 32 * 256 * sqrt(2)
@@ -78,28 +83,22 @@ void TMC2160Stepper::rms_current(uint16_t mA) {
   do {
     uint32_t denominator = V_fs * 0xFFFF >> 8;
     denominator *= CS+1;
-    scaler = numerator / denominator;
-
-    if (scaler > 255) scaler = 0; // Maximum
-    else if (scaler < 128) CS--;  // Try again with smaller CS
-  } while(0 < scaler && scaler < 128);
+    result = numerator / denominator;
 
+    if (result > 255) result = 0; // Maximum
+    else if (result < 128) CS--;  // Try again with smaller CS
+  } while(0 < result && result < 128);
 
   if (CS > 31)
     CS = 31;
 
-  GLOBAL_SCALER(scaler);
-  irun(CS);
-  ihold(CS*holdMultiplier);
+  scaler = result;
+  return CS;
 }
-void TMC2160Stepper::rms_current(uint16_t mA, float mult) {
-  holdMultiplier = mult;
-  rms_current(mA);
-}
-uint16_t TMC2160Stepper::cs2rms(uint8_t CS) {
-    uint16_t scaler = GLOBAL_SCALER();
-    if (!scaler) scaler = 256;
-    uint32_t numerator = scaler * (CS+1);
+
+uint16_t TMC_current::scaled_rms(uint8_t CS, float Rsense, uint8_t scaler) {
+    uint32_t numerator = scaler ? scaler : 256;
+    numerator *= CS+1;
     numerator *= 325;
     numerator >>= (8+5); // Divide by 256 and 32
     numerator *= 1000000;
@@ -108,31 +107,83 @@ uint16_t TMC2160Stepper::cs2rms(uint8_t CS) {
 
     return numerator / denominator;
 }
+
+void TMC2160Stepper::rms_current(uint16_t mA) {
+  Session session(*this);
+  uint8_t scaler = 0;
+  const uint8_t CS = TMC_current::scaled_cs(mA, Rsense, scaler);
+  GLOBAL_SCALER(scaler);
+  current_scale(CS);
+}
+void TMC2160Stepper::rms_current(uint16_t mA, float mult) {
+  holdMultiplier = mult;
+  rms_current(mA);
+}
+uint16_t TMC2160Stepper::cs2rms(uint8_t CS) {
+  return TMC_current::scaled_rms(CS, Rsense, GLOBAL_SCALER());
+}
 uint16_t TMC2160Stepper::rms_current() { return cs2rms(irun()); }
 
-void TMC2160Stepper::push() {
-  GCONF(GCONF_register.sr);
-  IHOLD_IRUN(IHOLD_IRUN_register.sr);
-  TPOWERDOWN(TPOWERDOWN_register.sr);
-  TPWMTHRS(TPWMTHRS_register.sr);
-  TCOOLTHRS(TCOOLTHRS_register.sr);
-  THIGH(THIGH_register.sr);
-  XDIRECT(XDIRECT_register.sr);
-  VDCMIN(VDCMIN_register.sr);
-  CHOPCONF(CHOPCONF_register.sr);
-  COOLCONF(COOLCONF_register.sr);
-  DCCTRL(DCCTRL_register.sr);
-  PWMCONF(PWMCONF_register.sr);
-  SHORT_CONF(SHORT_CONF_register.sr);
-  DRV_CONF(DRV_CONF_register.sr);
-  GLOBAL_SCALER(GLOBAL_SCALER_register.sr);
+bool TMC2160Stepper::shadow(uint8_t address, uint32_t &value) {
+  switch(address) {
+    SHADOW_REG(SHORT_CONF);
+    SHADOW_REG(DRV_CONF);
+    SHADOW_REG(GLOBAL_SCALER);
+    SHADOW_REG(PWMCONF_2160);
+  }
+  return TMC2130Stepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC2160_registers[] REGISTER_MAP_STORAGE = {
+  { 0x00, 18, TMC_access::RW,                   0x00000000 }, // GCONF
+  { 0x01,  3, TMC_access::RC | TMC_access::V,   0x00000000 }, // GSTAT
+  { 0x04, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // IOIN
+  { 0x06, 14, TMC_access::W,                    0x00000000 }, // OTP_PROG
+  { 0x07,  8, TMC_access::R,                    0x00000000 }, // OTP_READ
+  { 0x08,  5, TMC_access::RW | TMC_access::OTP, 0x00000000 }, // FACTORY_CONF
+  { 0x09, 19, TMC_access::W,                    0x00010606 }, // SHORT_CONF
+  { 0x0A, 22, TMC_access::W,                    0x00080400 }, // DRV_CONF
+  { 0x0B,  8, TMC_access::W,                    0x00000000 }, // GLOBAL_SCALER
+  { 0x0C, 16, TMC_access::R,                    0x00000000 }, // OFFSET_READ
+  { 0x10, 20, TMC_access::W,                    0x00000000 }, // IHOLD_IRUN
+  { 0x11,  8, TMC_access::W,                    0x0000000A }, // TPOWERDOWN
+  { 0x12, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // TSTEP
+  { 0x13, 20, TMC_access::W,                    0x00000000 }, // TPWMTHRS
+  { 0x14, 20, TMC_access::W,                    0x00000000 }, // TCOOLTHRS
+  { 0x15, 20, TMC_access::W,                    0x00000000 }, // THIGH
+  { 0x2D, 32, TMC_access::RW,                   0x00000000 }, // XDIRECT
+  { 0x33, 23, TMC_access::W,                    0x00000000 }, // VDCMIN
+  { 0x60, 32, TMC_access::W,                    0xAAAAB554 }, // MSLUT0
+  { 0x61, 32, TMC_access::W,                    0x4A9554AA }, // MSLUT1
+  { 0x62, 32, TMC_access::W,                    0x24492929 }, // MSLUT2
+  { 0x63, 32, TMC_access::W,                    0x10104222 }, // MSLUT3
+  { 0x64, 32, TMC_access::W,                    0xFBFFFFFF }, // MSLUT4
+  { 0x65, 32, TMC_access::W,                    0xB5BB777D }, // MSLUT5
+  { 0x66, 32, TMC_access::W,                    0x49295556 }, // MSLUT6
+  { 0x67, 32, TMC_access::W,                    0x00404222 }, // MSLUT7
+  { 0x68, 32, TMC_access::W,                    0xFFFF8056 }, // MSLUTSEL
+  { 0x69, 24, TMC_access::W,                    0x00F70000 }, // MSLUTSTART
+  { 0x6A, 10, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCNT
+  { 0x6B, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCURACT
+  { 0x6C, 32, TMC_access::RW,                   0x10410150 }, // CHOPCONF
+  { 0x6D, 25, TMC_access::W,                    0x00000000 }, // COOLCONF
+  { 0x6E, 24, TMC_access::W,                    0x00000000 }, // DCCTRL
+  { 0x6F, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // DRV_STATUS
+  { 0x70, 32, TMC_access::W,                    0xC40C001E }, // PWMCONF
+  { 0x71, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_SCALE
+  { 0x72, 24, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_AUTO
+  { 0x73, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // LOST_STEPS
+};
+
+TMC_register_map_t TMC2160Stepper::register_map() { return REGISTER_MAP(TMC2160_registers); }
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // R: IOIN
 uint32_t  TMC2160Stepper::IOIN() {
   return read(TMC2160_n::IOIN_t::address);
 }
+TMC2160_n::IOIN_t TMC2160Stepper::ioin_snapshot() { TMC2160_n::IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool    TMC2160Stepper::refl_step()      { TMC2160_n::IOIN_t r{0}; r.sr = IOIN(); return r.refl_step; }
 bool    TMC2160Stepper::refr_dir()       { TMC2160_n::IOIN_t r{0}; r.sr = IOIN(); return r.refr_dir; }
 bool    TMC2160Stepper::encb_dcen_cfg4() { TMC2160_n::IOIN_t r{0}; r.sr = IOIN(); return r.encb_dcen_cfg4; }
@@ -155,5 +206,6 @@ uint16_t TMC2160Stepper::OFFSET_READ() { return read(OFFSET_READ_t::address); }
 uint32_t TMC2160Stepper::PWM_SCALE() {
   return read(TMC2160_n::PWM_SCALE_t::address);
 }
+TMC2160_n::PWM_SCALE_t TMC2160Stepper::pwm_scale_snapshot() { TMC2160_n::PWM_SCALE_t r{0}; r.sr = PWM_SCALE(); return r; }
 uint8_t TMC2160Stepper::pwm_scale_sum()   { TMC2160_n::PWM_SCALE_t r{0}; r.sr = PWM_SCALE(); return r.pwm_scale_sum; }
 uint16_t TMC2160Stepper::pwm_scale_auto() { TMC2160_n::PWM_SCALE_t r{0}; r.sr = PWM_SCALE(); return r.pwm_scale_auto; }
@@ -1,6 +1,53 @@
 #include "TMCStepper.h"
 #include "TMC_MACROS.h"
 #include "SERIAL_SWITCH.h"
+#include <new>
+
+#if defined(ARDUINO_ARCH_AVR)
+	#include <avr/pgmspace.h>
+	#define CRC_TABLE_STORAGE PROGMEM
+	#define CRC_TABLE(i) pgm_read_byte(&crc_table[i])
+#else
+	#define CRC_TABLE_STORAGE
+	#define CRC_TABLE(i) crc_table[i]
+#endif
+
+// CRC8 with polynomial 0x07 as used by the TMC UART, which feeds each byte LSB
+// first. Kept bit reversed so that every byte is a single lookup.
+static constexpr uint8_t crc_table[256] CRC_TABLE_STORAGE = {
+	0x00, 0x91, 0xE3, 0x72, 0x07, 0x96, 0xE4, 0x75,
+	0x0E, 0x9F, 0xED, 0x7C, 0x09, 0x98, 0xEA, 0x7B,
+	0x1C, 0x8D, 0xFF, 0x6E, 0x1B, 0x8A, 0xF8, 0x69,
+	0x12, 0x83, 0xF1, 0x60, 0x15, 0x84, 0xF6, 0x67,
+	0x38, 0xA9, 0xDB, 0x4A, 0x3F, 0xAE, 0xDC, 0x4D,
+	0x36, 0xA7, 0xD5, 0x44, 0x31, 0xA0, 0xD2, 0x43,
+	0x24, 0xB5, 0xC7, 0x56, 0x23, 0xB2, 0xC0, 0x51,
+	0x2A, 0xBB, 0xC9, 0x58, 0x2D, 0xBC, 0xCE, 0x5F,
+	0x70, 0xE1, 0x93, 0x02, 0x77, 0xE6, 0x94, 0x05,
+	0x7E, 0xEF, 0x9D, 0x0C, 0x79, 0xE8, 0x9A, 0x0B,
+	0x6C, 0xFD, 0x8F, 0x1E, 0x6B, 0xFA, 0x88, 0x19,
+	0x62, 0xF3, 0x81, 0x10, 0x65, 0xF4, 0x86, 0x17,
+	0x48, 0xD9, 0xAB, 0x3A, 0x4F, 0xDE, 0xAC, 0x3D,
+	0x46, 0xD7, 0xA5, 0x34, 0x41, 0xD0, 0xA2, 0x33,
+	0x54, 0xC5, 0xB7, 0x26, 0x53, 0xC2, 0xB0, 0x21,
+	0x5A, 0xCB, 0xB9, 0x28, 0x5D, 0xCC, 0xBE, 0x2F,
+	0xE0, 0x71, 0x03, 0x92, 0xE7, 0x76, 0x04, 0x95,
+	0xEE, 0x7F, 0x0D, 0x9C, 0xE9, 0x78, 0x0A, 0x9B,
+	0xFC, 0x6D, 0x1F, 0x8E, 0xFB, 0x6A, 0x18, 0x89,
+	0xF2, 0x63, 0x11, 0x80, 0xF5, 0x64, 0x16, 0x87,
+	0xD8, 0x49, 0x3B, 0xAA, 0xDF, 0x4E, 0x3C, 0xAD,
+	0xD6, 0x47, 0x35, 0xA4, 0xD1, 0x40, 0x32, 0xA3,
+	0xC4, 0x55, 0x27, 0xB6, 0xC3, 0x52, 0x20, 0xB1,
+	0xCA, 0x5B, 0x29, 0xB8, 0xCD, 0x5C, 0x2E, 0xBF,
+	0x90, 0x01, 0x73, 0xE2, 0x97, 0x06, 0x74, 0xE5,
+	0x9E, 0x0F, 0x7D, 0xEC, 0x99, 0x08, 0x7A, 0xEB,
+	0x8C, 0x1D, 0x6F, 0xFE, 0x8B, 0x1A, 0x68, 0xF9,
+	0x82, 0x13, 0x61, 0xF0, 0x85, 0x14, 0x66, 0xF7,
+	0xA8, 0x39, 0x4B, 0xDA, 0xAF, 0x3E, 0x4C, 0xDD,
+	0xA6, 0x37, 0x45, 0xD4, 0xA1, 0x30, 0x42, 0xD3,
+	0xB4, 0x25, 0x57, 0xC6, 0xB3, 0x22, 0x50, 0xC1,
+	0xBA, 0x2B, 0x59, 0xC8, 0xBD, 0x2C, 0x5E, 0xCF
+};
 
 // Protected
 // addr needed for TMC2209
@@ -12,14 +59,43 @@ TMC2208Stepper::TMC2208Stepper(Stream * SerialPort, float RS, uint8_t addr) :
 		defaults();
 	}
 
+TMC2208Stepper::TMC2208Stepper(UARTBus &bus, float RS, uint8_t addr) :
+	TMC2208Stepper(bus.serial, RS, addr)
+	{
+		uart_bus = &bus;
+		line = &bus.line;
+	}
+
 TMC2208Stepper::TMC2208Stepper(Stream * SerialPort, float RS, uint8_t addr, uint16_t mul_pin1, uint16_t mul_pin2) :
 	TMC2208Stepper(SerialPort, RS)
 	{
-		SSwitch *SMulObj = new SSwitch(mul_pin1, mul_pin2, addr);
-		sswitch = SMulObj;
+		sswitch = SSwitch::channel(mul_pin1, mul_pin2, addr);
+		// Without its switch the driver would talk to whichever channel is selected
+		if (sswitch == nullptr) HWSerial = nullptr;
 	}
 
 #if SW_CAPABLE_PLATFORM
+	/**
+	 *  Drivers given the same pins share one port. The ports are constructed
+	 *  in a static pool, nullptr once all TMC_SW_SERIAL_PORTS are taken.
+	 */
+	static SoftwareSerial *software_serial(uint16_t SW_RX_pin, uint16_t SW_TX_pin) {
+		static struct {
+			uint16_t rx, tx;
+			alignas(SoftwareSerial) uint8_t storage[sizeof(SoftwareSerial)];
+		} pool[TMC_SW_SERIAL_PORTS];
+		static uint8_t used = 0;
+
+		for (uint8_t i = 0; i < used; i++) {
+			if (pool[i].rx == SW_RX_pin && pool[i].tx == SW_TX_pin)
+				return reinterpret_cast<SoftwareSerial*>(pool[i].storage);
+		}
+		if (used == TMC_SW_SERIAL_PORTS) return nullptr;
+		pool[used].rx = SW_RX_pin;
+		pool[used].tx = SW_TX_pin;
+		return new (pool[used++].storage) SoftwareSerial(SW_RX_pin, SW_TX_pin);
+	}
+
 	// Protected
 	// addr needed for TMC2209
 	TMC2208Stepper::TMC2208Stepper(uint16_t SW_RX_pin, uint16_t SW_TX_pin, float RS, uint8_t addr) :
@@ -27,8 +103,7 @@ TMC2208Stepper::TMC2208Stepper(Stream * SerialPort, float RS, uint8_t addr, uint
 		RXTX_pin(SW_RX_pin == SW_TX_pin ? SW_RX_pin : 0),
 		slave_address(addr)
 		{
-			SoftwareSerial *SWSerialObj = new SoftwareSerial(SW_RX_pin, SW_TX_pin);
-			SWSerial = SWSerialObj;
+			SWSerial = software_serial(SW_RX_pin, SW_TX_pin);
 			defaults();
 		}
 
@@ -37,6 +112,7 @@ TMC2208Stepper::TMC2208Stepper(Stream * SerialPort, float RS, uint8_t addr, uint
 		{
 			SWSerial->begin(baudrate);
 			SWSerial->end();
+			baud_rate(baudrate);
 		}
 		#if defined(ARDUINO_ARCH_AVR)
 			if (RXTX_pin > 0) {
@@ -53,7 +129,6 @@ void TMC2208Stepper::begin() {
 	#endif
 	pdn_disable(true);
 	mstep_reg_select(true);
-
 }
 
 void TMC2208Stepper::defaults() {
@@ -76,36 +151,143 @@ void TMC2208Stepper::defaults() {
   //MSLUTSTART_register.start_sin90 = 247;
 }
 
-void TMC2208Stepper::push() {
-	GCONF(GCONF_register.sr);
-	IHOLD_IRUN(IHOLD_IRUN_register.sr);
-	SLAVECONF(SLAVECONF_register.sr);
-	TPOWERDOWN(TPOWERDOWN_register.sr);
-	TPWMTHRS(TPWMTHRS_register.sr);
-	VACTUAL(VACTUAL_register.sr);
-	CHOPCONF(CHOPCONF_register.sr);
-	PWMCONF(PWMCONF_register.sr);
+bool TMC2208Stepper::shadow(uint8_t address, uint32_t &value) {
+	switch(address) {
+		SHADOW_REG(GCONF);
+		SHADOW_REG(SLAVECONF);
+		SHADOW_REG(FACTORY_CONF);
+		SHADOW_REG(VACTUAL);
+		SHADOW_REG(CHOPCONF);
+		SHADOW_REG(PWMCONF);
+	}
+	return TMCStepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC2208_registers[] REGISTER_MAP_STORAGE = {
+	{ 0x00, 10, TMC_access::RW,                   0x00000101 }, // GCONF
+	{ 0x01,  3, TMC_access::RC | TMC_access::V,   0x00000000 }, // GSTAT
+	{ 0x02,  8, TMC_access::R | TMC_access::V,    0x00000000 }, // IFCNT
+	{ 0x03, 12, TMC_access::W,                    0x00000000 }, // SLAVECONF
+	{ 0x04, 16, TMC_access::W,                    0x00000000 }, // OTP_PROG
+	{ 0x05, 24, TMC_access::R,                    0x00000000 }, // OTP_READ
+	{ 0x06, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // IOIN
+	{ 0x07, 10, TMC_access::RW | TMC_access::OTP, 0x00000000 }, // FACTORY_CONF
+	{ 0x10, 20, TMC_access::W,                    0x00011F10 }, // IHOLD_IRUN
+	{ 0x11,  8, TMC_access::W,                    0x00000014 }, // TPOWERDOWN
+	{ 0x12, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // TSTEP
+	{ 0x13, 20, TMC_access::W,                    0x00000000 }, // TPWMTHRS
+	{ 0x22, 24, TMC_access::W,                    0x00000000 }, // VACTUAL
+	{ 0x6A, 10, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCNT
+	{ 0x6B, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCURACT
+	{ 0x6C, 32, TMC_access::RW,                   0x10000053 }, // CHOPCONF
+	{ 0x6F, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // DRV_STATUS
+	{ 0x70, 32, TMC_access::RW,                   0xC10D0024 }, // PWMCONF
+	{ 0x71, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_SCALE
+	{ 0x72, 24, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_AUTO
+};
+
+TMC_register_map_t TMC2208Stepper::register_map() { return REGISTER_MAP(TMC2208_registers); }
+
 bool TMC2208Stepper::isEnabled() { return !enn() && toff(); }
 
+/**
+ *  Derives the frame gap and reply timeout from the line speed. On a
+ *  UARTBus this sets the line shared by all attached drivers.
+ */
+void TMC2208Stepper::baud_rate(uint32_t baud) {
+	line->baud_rate(baud);
+}
+
+/**
+ *  Time a reply may take once the request has left. Unless set with
+ *  reply_timeout(), twice the wire time of SENDDELAY (n selects (n|1)*8
+ *  bit times) and the reply, which leaves room for interrupt and
+ *  scheduling latency.
+ */
+uint16_t TMC2208Stepper::reply_time() {
+	if (reply_timeout_us != 0) return reply_timeout_us;
+	if (line->byte_time_us == 0) return 7000; // Unknown baud rate
+
+	const uint32_t bits = (SLAVECONF_register.senddelay | 1) * 8 + 8*10;
+	const uint32_t timeout = 2 * bits * line->byte_time_us / 10 + 500;
+	return timeout > 0xFFFF ? 0xFFFF : timeout;
+}
+
+/**
+ *  Waits for the previous datagram to leave the port, then for the frame
+ *  gap counted from the end of transmission. Called before each blocking
+ *  datagram, so the multiplexer never switches while bytes are still
+ *  going out. Without a baud rate the end of a datagram that was handed
+ *  to the port less than a frame gap ago is taken to be the flush.
+ */
+void TMC2208Stepper::wait_line(bool queue) {
+	if (queue && (sswitch == nullptr || sswitch->is_active())) return;
+
+	if (HWSerial != nullptr) HWSerial->flush();
+	const uint32_t now = micros();
+	if (static_cast<int32_t>(line->idle - now) > 0 || (line->byte_time_us == 0 && !line->ready())) line->idle = now;
+	while (!line->ready()) {}
+}
+
+/**
+ *  True if a datagram may go out now. With queue set, datagrams to the
+ *  selected channel are left to pile up in the transmit buffer, as fast
+ *  writes do.
+ */
+bool TMC2208Stepper::line_ready(bool queue) {
+	if (queue && (sswitch == nullptr || sswitch->is_active())) return true;
+	return line->ready();
+}
+
 uint8_t TMC2208Stepper::calcCRC(uint8_t datagram[], uint8_t len) {
 	uint8_t crc = 0;
 	for (uint8_t i = 0; i < len; i++) {
-		uint8_t currentByte = datagram[i];
-		for (uint8_t j = 0; j < 8; j++) {
-			if ((crc >> 7) ^ (currentByte & 0x01)) {
-				crc = (crc << 1) ^ 0x07;
-			} else {
-				crc = (crc << 1);
-			}
-			crc &= 0xff;
-			currentByte = currentByte >> 1;
-		}
+		crc = crc_update(crc, datagram[i]);
 	}
+	return crc_result(crc);
+}
+
+// Streaming form of calcCRC(), start with 0 and finish with crc_result()
+uint8_t TMC2208Stepper::crc_update(uint8_t crc, uint8_t data) {
+	return CRC_TABLE(crc ^ data);
+}
+
+uint8_t TMC2208Stepper::crc_result(uint8_t crc) {
+	crc = (crc & 0xF0) >> 4 | (crc & 0x0F) << 4;
+	crc = (crc & 0xCC) >> 2 | (crc & 0x33) << 2;
+	crc = (crc & 0xAA) >> 1 | (crc & 0x55) << 1;
 	return crc;
 }
 
+void TMC2208Stepper::write_datagram(uint8_t datagram[8], uint8_t slave, uint8_t addr, uint32_t value) {
+	datagram[0] = TMC2208_SYNC;
+	datagram[1] = slave;
+	datagram[2] = addr | TMC_WRITE;
+	datagram[3] = value >> 24;
+	datagram[4] = value >> 16;
+	datagram[5] = value >> 8;
+	datagram[6] = value;
+	datagram[7] = calcCRC(datagram, 7);
+}
+
+void TMC2208Stepper::read_datagram(uint8_t datagram[4], uint8_t slave, uint8_t addr) {
+	datagram[0] = TMC2208_SYNC;
+	datagram[1] = slave;
+	datagram[2] = addr | TMC_READ;
+	datagram[3] = calcCRC(datagram, 3);
+}
+
+// CRC over the first seven bytes matches the last, a zero CRC is a dead line
+bool TMC2208Stepper::reply_valid(uint64_t reply) {
+	uint8_t crc = 0;
+	for (int8_t shift = 56; shift > 0; shift -= 8) {
+		crc = crc_update(crc, reply>>shift);
+	}
+	crc = crc_result(crc);
+	return crc == static_cast<uint8_t>(reply) && crc != 0;
+}
+
 __attribute__((weak))
 int TMC2208Stepper::available() {
 	int out = 0;
@@ -172,6 +354,21 @@ uint8_t TMC2208Stepper::serial_write(const uint8_t data) {
 	return out;
 }
 
+// Whole datagrams go out with one call, the transmit buffer does the rest
+__attribute__((weak))
+size_t TMC2208Stepper::serial_write(const uint8_t *data, size_t length) {
+	#if SW_CAPABLE_PLATFORM
+		if (SWSerial != nullptr) {
+			return SWSerial->write(data, length);
+		} else
+	#endif
+		if (HWSerial != nullptr) {
+			return HWSerial->write(data, length);
+		}
+
+	return 0;
+}
+
 __attribute__((weak))
 void TMC2208Stepper::postWriteCommunication() {}
 
@@ -185,24 +382,88 @@ void TMC2208Stepper::postReadCommunication() {
 }
 
 void TMC2208Stepper::write(uint8_t addr, uint32_t regVal) {
-	uint8_t len = 7;
-	addr |= TMC_WRITE;
-	uint8_t datagram[] = {TMC2208_SYNC, slave_address, addr, (uint8_t)(regVal>>24), (uint8_t)(regVal>>16), (uint8_t)(regVal>>8), (uint8_t)(regVal>>0), 0x00};
+	if (defer_write(addr)) return;
+	if (uart_bus != nullptr) uart_bus->flush();
+	wait_line(fast_writes);
+	send_write(addr, regVal);
+}
 
-	datagram[len] = calcCRC(datagram, len);
+// Sends right away, the caller waits for the line
+void TMC2208Stepper::send_write(uint8_t addr, uint32_t regVal) {
+	uint8_t len = 7;
+	uint8_t datagram[8];
+	write_datagram(datagram, slave_address, addr, regVal);
 
 	preWriteCommunication();
 
-	for(uint8_t i=0; i<=len; i++) {
-		bytesWritten += serial_write(datagram[i]);
+	if (line->half_duplex) {
+		discard_input(); // Keep the receive buffer from filling up with echo
+		line->echo_pending += len+1;
 	}
+	bytesWritten += serial_write(datagram, len+1);
+	line->sent(len+1);
 	postWriteCommunication();
+	addr &= ~TMC_WRITE;
+	cache_written(addr);
 
-	delay(replyDelay);
+	if (fast_writes) writes_sent++;
 }
 
-uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, uint16_t timeout) {
+/**
+ *  In fast write mode writes are sent without the reply delay and counted.
+ *  verify_writes() compares the count with the increment of the interface
+ *  counter IFCNT. Keep fewer than 256 writes between checks, the counter
+ *  wraps around.
+ */
+void TMC2208Stepper::fast_write_mode(bool enable) {
+	if (enable && !fast_writes) {
+		ifcnt_base = IFCNT();
+		writes_sent = 0;
+	}
+	fast_writes = enable;
+}
+
+/**
+ *  Returns true if every write since the last check reached the driver.
+ *  Otherwise no register is known to match the device any more, so
+ *  push_changed() sends them all again.
+ */
+bool TMC2208Stepper::verify_writes() {
+	const uint8_t ifcnt = IFCNT();
+	const bool ok = !CRCerror && static_cast<uint8_t>(ifcnt - ifcnt_base) == writes_sent;
+
+	if (!ok) invalidate_cache();
+	if (CRCerror) return false; // Keep counting from the last good reading
+
+	ifcnt_base = ifcnt;
+	writes_sent = 0;
+	return ok;
+}
+
+/**
+ *  Single wire mode: every transmitted byte is received again. Their number
+ *  is known, so the echo is dropped by count and the reply is read as a
+ *  fixed 8 byte frame instead of being searched for.
+ */
+void TMC2208Stepper::half_duplex(bool enable) {
+	line->half_duplex = enable;
+	line->echo_pending = 0;
+}
+
+// Drop received bytes. Echo that is still on its way stays accounted for.
+void TMC2208Stepper::discard_input() {
+	if (line->half_duplex) {
+		while (line->echo_pending > 0 && available() > 0) {
+			serial_read();
+			line->echo_pending--;
+		}
+		if (line->echo_pending > 0) return;
+	}
 	while (available() > 0) serial_read(); // Flush
+}
+
+uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, uint16_t timeout) {
+	discard_input();
 
 	#if defined(ARDUINO_ARCH_AVR)
 		if (RXTX_pin > 0) {
@@ -211,7 +472,8 @@ uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, ui
 		}
 	#endif
 
-	for(int i=0; i<=len; i++) serial_write(datagram[i]);
+	serial_write(datagram, len+1);
+	const uint32_t start = line->sent(len+1);
 
 	#if defined(ARDUINO_ARCH_AVR)
 		if (RXTX_pin > 0) {
@@ -219,43 +481,49 @@ uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, ui
 		}
 	#endif
 
-	delay(this->replyDelay);
-
 	// scan for the rx frame and read it
-	uint32_t ms = millis();
-	uint32_t sync_target = (static_cast<uint32_t>(datagram[0])<<16) | 0xFF00 | datagram[2];
+	uint32_t sync_target = reply_header(datagram[2]);
 	uint32_t sync = 0;
 
-	do {
-		uint32_t ms2 = millis();
-		if (ms2 != ms) {
-			// 1ms tick
-			ms = ms2;
-			timeout--;
+	if (line->half_duplex) {
+		// The echo ends when our request has left, the reply follows
+		for (uint16_t echo = line->echo_pending + len+1; echo > 0;) {
+			if (static_cast<int32_t>(micros() - start) > timeout) return 0;
+			if (serial_read() >= 0) echo--;
 		}
-		if (!timeout) return 0;
+		line->echo_pending = 0;
 
-		int16_t res = serial_read();
-		if (res < 0) continue;
+		for (uint8_t i=0; i<3;) {
+			if (static_cast<int32_t>(micros() - start) > timeout) return 0;
+
+			int16_t res = serial_read();
+			if (res < 0) continue;
+
+			sync = (sync << 8) | (res & 0xFF);
+			i++;
+		}
+		if (sync != sync_target) {
+			line->echo_pending = 5; // Rest of the frame, dropped before the retry
+			return 0;
+		}
+	} else {
+		do {
+			if (static_cast<int32_t>(micros() - start) > timeout) return 0;
 
-		sync <<= 8;
-		sync |= res & 0xFF;
-		sync &= 0xFFFFFF;
+			int16_t res = serial_read();
+			if (res < 0) continue;
 
-	} while (sync != sync_target);
+			sync <<= 8;
+			sync |= res & 0xFF;
+			sync &= 0xFFFFFF;
+
+		} while (sync != sync_target);
+	}
 
 	uint64_t out = sync;
-	ms = millis();
-	timeout = this->abort_window;
 
 	for(uint8_t i=0; i<5;) {
-		uint32_t ms2 = millis();
-		if (ms2 != ms) {
-			// 1ms tick
-			ms = ms2;
-			timeout--;
-		}
-		if (!timeout) return 0;
+		if (static_cast<int32_t>(micros() - start) > timeout) return 0;
 
 		int16_t res = serial_read();
 		if (res < 0) continue;
@@ -280,32 +548,21 @@ uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, ui
 
 uint32_t TMC2208Stepper::read(uint8_t addr) {
 	constexpr uint8_t len = 3;
-	addr |= TMC_READ;
-	uint8_t datagram[] = {TMC2208_SYNC, slave_address, addr, 0x00};
-	datagram[len] = calcCRC(datagram, len);
+	uint8_t datagram[4];
+	read_datagram(datagram, slave_address, addr);
 	uint64_t out = 0x00000000UL;
 
+	if (uart_bus != nullptr) uart_bus->flush();
+
 	for (uint8_t i = 0; i < max_retries; i++) {
+		wait_line();
 		preReadCommunication();
-		out = _sendDatagram(datagram, len, abort_window);
+		out = _sendDatagram(datagram, len, reply_time());
 		postReadCommunication();
+		line->idle = micros(); // End of the reply or timeout
 
-		delay(replyDelay);
-
-		CRCerror = false;
-		uint8_t out_datagram[] = {
-			static_cast<uint8_t>(out>>56),
-			static_cast<uint8_t>(out>>48),
-			static_cast<uint8_t>(out>>40),
-			static_cast<uint8_t>(out>>32),
-			static_cast<uint8_t>(out>>24),
-			static_cast<uint8_t>(out>>16),
-			static_cast<uint8_t>(out>> 8),
-			static_cast<uint8_t>(out>> 0)
-		};
-		uint8_t crc = calcCRC(out_datagram, 7);
-		if ((crc != static_cast<uint8_t>(out)) || crc == 0 ) {
-			CRCerror = true;
+		CRCerror = !reply_valid(out);
+		if (CRCerror) {
 			out = 0;
 		} else {
 			break;
@@ -315,6 +572,27 @@ uint32_t TMC2208Stepper::read(uint8_t addr) {
 	return out>>8;
 }
 
+/**
+ *  Queue a read or write on the UARTBus of the driver and return. See
+ *  UARTBus, which runs the transactions. False if the driver is not on a
+ *  bus or the queue is full.
+ */
+bool TMC2208Stepper::start_read(uint8_t addr, ReadCallback callback) {
+	return uart_bus != nullptr && uart_bus->read(*this, addr, callback);
+}
+
+bool TMC2208Stepper::start_write(uint8_t addr, uint32_t regVal) {
+	return uart_bus != nullptr && uart_bus->write(*this, addr, regVal);
+}
+
+bool TMC2208Stepper::poll() {
+	return uart_bus != nullptr && uart_bus->poll();
+}
+
+void TMC2208Stepper::receive(uint8_t data) {
+	if (uart_bus != nullptr) uart_bus->receive(data);
+}
+
 uint8_t TMC2208Stepper::IFCNT() {
 	return read(IFCNT_t::address);
 }
@@ -326,7 +604,7 @@ void TMC2208Stepper::SLAVECONF(uint16_t input) {
 uint16_t TMC2208Stepper::SLAVECONF() {
 	return SLAVECONF_register.sr;
 }
-void TMC2208Stepper::senddelay(uint8_t B) 	{ SLAVECONF_register.senddelay = B; write(SLAVECONF_register.address, SLAVECONF_register.sr); }
+void TMC2208Stepper::senddelay(uint8_t B) 	{ WRITE_FIELD(SLAVECONF, 8, 4); }
 uint8_t TMC2208Stepper::senddelay() 		{ return SLAVECONF_register.senddelay; }
 
 void TMC2208Stepper::OTP_PROG(uint16_t input) {
@@ -340,6 +618,7 @@ uint32_t TMC2208Stepper::OTP_READ() {
 uint32_t TMC2208Stepper::IOIN() {
 	return read(TMC2208_n::IOIN_t::address);
 }
+TMC2208_n::IOIN_t TMC2208Stepper::ioin_snapshot() { TMC2208_n::IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool TMC2208Stepper::enn()			{ TMC2208_n::IOIN_t r{0}; r.sr = IOIN(); return r.enn;		}
 bool TMC2208Stepper::ms1()			{ TMC2208_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms1;		}
 bool TMC2208Stepper::ms2()			{ TMC2208_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms2;		}
@@ -353,6 +632,7 @@ uint8_t TMC2208Stepper::version() 	{ TMC2208_n::IOIN_t r{0}; r.sr = IOIN(); retu
 uint32_t TMC2224Stepper::IOIN() {
 	return read(TMC2224_n::IOIN_t::address);
 }
+TMC2224_n::IOIN_t TMC2224Stepper::ioin_snapshot() { TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool TMC2224Stepper::enn()			{ TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r.enn;		}
 bool TMC2224Stepper::ms1()			{ TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms1;		}
 bool TMC2224Stepper::ms2()			{ TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms2;		}
@@ -364,14 +644,14 @@ bool TMC2224Stepper::dir()			{ TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r.d
 uint8_t TMC2224Stepper::version() 	{ TMC2224_n::IOIN_t r{0}; r.sr = IOIN(); return r.version;	}
 
 uint16_t TMC2208Stepper::FACTORY_CONF() {
-	return read(FACTORY_CONF_register.address);
+	return read_cached(FACTORY_CONF_register);
 }
 void TMC2208Stepper::FACTORY_CONF(uint16_t input) {
 	FACTORY_CONF_register.sr = input;
 	write(FACTORY_CONF_register.address, FACTORY_CONF_register.sr);
 }
-void TMC2208Stepper::fclktrim(uint8_t B){ FACTORY_CONF_register.fclktrim = B; write(FACTORY_CONF_register.address, FACTORY_CONF_register.sr); }
-void TMC2208Stepper::ottrim(uint8_t B)	{ FACTORY_CONF_register.ottrim = B; write(FACTORY_CONF_register.address, FACTORY_CONF_register.sr); }
+void TMC2208Stepper::fclktrim(uint8_t B){ WRITE_FIELD(FACTORY_CONF, 0, 5); }
+void TMC2208Stepper::ottrim(uint8_t B)	{ WRITE_FIELD(FACTORY_CONF, 8, 2); }
 uint8_t TMC2208Stepper::fclktrim()		{ FACTORY_CONF_t r{0}; r.sr = FACTORY_CONF(); return r.fclktrim; }
 uint8_t TMC2208Stepper::ottrim()		{ FACTORY_CONF_t r{0}; r.sr = FACTORY_CONF(); return r.ottrim; }
 
@@ -386,6 +666,7 @@ uint32_t TMC2208Stepper::VACTUAL() {
 uint32_t TMC2208Stepper::PWM_SCALE() {
 	return read(TMC2208_n::PWM_SCALE_t::address);
 }
+TMC2208_n::PWM_SCALE_t TMC2208Stepper::pwm_scale_snapshot() { TMC2208_n::PWM_SCALE_t r{0}; r.sr = PWM_SCALE(); return r; }
 uint8_t TMC2208Stepper::pwm_scale_sum() {
 	TMC2208_n::PWM_SCALE_t r{0};
 	r.sr = PWM_SCALE();
@@ -409,5 +690,6 @@ int16_t TMC2208Stepper::pwm_scale_auto() {
 uint32_t TMC2208Stepper::PWM_AUTO() {
 	return read(PWM_AUTO_t::address);
 }
+PWM_AUTO_t TMC2208Stepper::pwm_auto_snapshot() { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r; }
 uint8_t TMC2208Stepper::pwm_ofs_auto()  { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r.pwm_ofs_auto; }
 uint8_t TMC2208Stepper::pwm_grad_auto() { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r.pwm_grad_auto; }
@@ -1,8 +1,10 @@
 #include "TMCStepper.h"
+#include "TMC_MACROS.h"
 
 uint32_t TMC2209Stepper::IOIN() {
 	return read(TMC2209_n::IOIN_t::address);
 }
+TMC2209_n::IOIN_t TMC2209Stepper::ioin_snapshot() { TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool TMC2209Stepper::enn()			{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r.enn;		}
 bool TMC2209Stepper::ms1()			{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms1;		}
 bool TMC2209Stepper::ms2()			{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r.ms2;		}
@@ -13,18 +15,45 @@ bool TMC2209Stepper::spread_en()	{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return
 bool TMC2209Stepper::dir()			{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r.dir;		}
 uint8_t TMC2209Stepper::version() 	{ TMC2209_n::IOIN_t r{0}; r.sr = IOIN(); return r.version;	}
 
-void TMC2209Stepper::push() {
-	IHOLD_IRUN(IHOLD_IRUN_register.sr);
-	TPOWERDOWN(TPOWERDOWN_register.sr);
-	TPWMTHRS(TPWMTHRS_register.sr);
-	GCONF(GCONF_register.sr);
-	SLAVECONF(SLAVECONF_register.sr);
-	VACTUAL(VACTUAL_register.sr);
-	CHOPCONF(CHOPCONF_register.sr);
-	PWMCONF(PWMCONF_register.sr);
-	TCOOLTHRS(TCOOLTHRS_register.sr);
+bool TMC2209Stepper::shadow(uint8_t address, uint32_t &value) {
+	switch(address) {
+		SHADOW_REG(TCOOLTHRS);
+		SHADOW_REG(SGTHRS);
+		SHADOW_REG(COOLCONF);
+	}
+	return TMC2208Stepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC2209_registers[] REGISTER_MAP_STORAGE = {
+	{ 0x00, 10, TMC_access::RW,                   0x00000101 }, // GCONF
+	{ 0x01,  3, TMC_access::RC | TMC_access::V,   0x00000000 }, // GSTAT
+	{ 0x02,  8, TMC_access::R | TMC_access::V,    0x00000000 }, // IFCNT
+	{ 0x03, 12, TMC_access::W,                    0x00000000 }, // SLAVECONF
+	{ 0x04, 16, TMC_access::W,                    0x00000000 }, // OTP_PROG
+	{ 0x05, 24, TMC_access::R,                    0x00000000 }, // OTP_READ
+	{ 0x06, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // IOIN
+	{ 0x07, 10, TMC_access::RW | TMC_access::OTP, 0x00000000 }, // FACTORY_CONF
+	{ 0x10, 20, TMC_access::W,                    0x00011F10 }, // IHOLD_IRUN
+	{ 0x11,  8, TMC_access::W,                    0x00000014 }, // TPOWERDOWN
+	{ 0x12, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // TSTEP
+	{ 0x13, 20, TMC_access::W,                    0x00000000 }, // TPWMTHRS
+	{ 0x14, 20, TMC_access::W,                    0x00000000 }, // TCOOLTHRS
+	{ 0x22, 24, TMC_access::W,                    0x00000000 }, // VACTUAL
+	{ 0x40,  8, TMC_access::W,                    0x00000000 }, // SGTHRS
+	{ 0x41, 10, TMC_access::R | TMC_access::V,    0x00000000 }, // SG_RESULT
+	{ 0x42, 16, TMC_access::W,                    0x00000000 }, // COOLCONF
+	{ 0x6A, 10, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCNT
+	{ 0x6B, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCURACT
+	{ 0x6C, 32, TMC_access::RW,                   0x10000053 }, // CHOPCONF
+	{ 0x6F, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // DRV_STATUS
+	{ 0x70, 32, TMC_access::RW,                   0xC10D0024 }, // PWMCONF
+	{ 0x71, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_SCALE
+	{ 0x72, 24, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_AUTO
+};
+
+TMC_register_map_t TMC2209Stepper::register_map() { return REGISTER_MAP(TMC2209_registers); }
+
 void TMC2209Stepper::SGTHRS(uint8_t input) {
 	SGTHRS_register.sr = input;
 	write(SGTHRS_register.address, SGTHRS_register.sr);
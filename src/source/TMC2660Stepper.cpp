@@ -8,65 +8,73 @@ TMC2660Stepper::TMC2660Stepper(uint16_t pinCS, float RS) :
 
 TMC2660Stepper::TMC2660Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) :
   _pinCS(pinCS),
-  Rsense(default_RS)
-  {
-    SW_SPIClass *SW_SPI_Obj = new SW_SPIClass(pinMOSI, pinMISO, pinSCK);
-    TMC_SW_SPI = SW_SPI_Obj;
-  }
+  Rsense(default_RS),
+  TMC_SW_SPI(software_spi(pinMOSI, pinMISO, pinSCK))
+  {}
 
 TMC2660Stepper::TMC2660Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) :
   _pinCS(pinCS),
-  Rsense(RS)
-  {
-    SW_SPIClass *SW_SPI_Obj = new SW_SPIClass(pinMOSI, pinMISO, pinSCK);
-    TMC_SW_SPI = SW_SPI_Obj;
-  }
+  Rsense(RS),
+  TMC_SW_SPI(software_spi(pinMOSI, pinMISO, pinSCK))
+  {}
+
+// Shared with the other drivers on these pins, hardware SPI once the pool is exhausted
+SW_SPIClass *TMC2660Stepper::software_spi(uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK) {
+  SPIChain *chain = SPIChain::software(pinMOSI, pinMISO, pinSCK);
+  return chain != nullptr ? chain->TMC_SW_SPI : nullptr;
+}
 
 void TMC2660Stepper::switchCSpin(bool state) {
   // Allows for overriding in child class to make use of fast io
   digitalWrite(_pinCS, state);
 }
 
-uint32_t TMC2660Stepper::read() {
-  uint32_t response = 0UL;
-  uint32_t dummy = ((uint32_t)DRVCONF_register.address<<17) | DRVCONF_register.sr;
+/**
+ *  Block transfer of a whole 20 bit datagram.
+ *  The received bytes replace the sent ones in buf.
+ */
+__attribute__((weak))
+void TMC2660Stepper::transfer(uint8_t *buf, const uint8_t count) {
   if (TMC_SW_SPI != nullptr) {
     switchCSpin(LOW);
-    response |= TMC_SW_SPI->transfer((dummy >> 16) & 0xFF);
-    response <<= 8;
-    response |= TMC_SW_SPI->transfer((dummy >>  8) & 0xFF);
-    response <<= 8;
-    response |= TMC_SW_SPI->transfer(dummy & 0xFF);
+    for (uint8_t i = 0; i < count; i++) {
+      buf[i] = TMC_SW_SPI->transfer(buf[i]);
+    }
   } else {
     SPI.beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
     switchCSpin(LOW);
-    response |= SPI.transfer((dummy >> 16) & 0xFF);
-    response <<= 8;
-    response |= SPI.transfer((dummy >>  8) & 0xFF);
-    response <<= 8;
-    response |= SPI.transfer(dummy & 0xFF);
+    SPI.transfer(buf, count);
     SPI.endTransaction();
   }
   switchCSpin(HIGH);
+}
+
+uint32_t TMC2660Stepper::read() {
+  uint32_t response = 0UL;
+  uint32_t dummy = ((uint32_t)DRVCONF_register.address<<17) | DRVCONF_register.sr;
+  uint8_t buf[3] = {
+    static_cast<uint8_t>(dummy >> 16),
+    static_cast<uint8_t>(dummy >>  8),
+    static_cast<uint8_t>(dummy >>  0)
+  };
+  transfer(buf, 3);
+
+  response |= buf[0];
+  response <<= 8;
+  response |= buf[1];
+  response <<= 8;
+  response |= buf[2];
   return response >> 4;
 }
 
 void TMC2660Stepper::write(uint8_t addressByte, uint32_t config) {
   uint32_t data = (uint32_t)addressByte<<17 | config;
-  if (TMC_SW_SPI != nullptr) {
-    switchCSpin(LOW);
-    TMC_SW_SPI->transfer((data >> 16) & 0xFF);
-    TMC_SW_SPI->transfer((data >>  8) & 0xFF);
-    TMC_SW_SPI->transfer(data & 0xFF);
-  } else {
-    SPI.beginTransaction(SPISettings(spi_speed, MSBFIRST, SPI_MODE3));
-    switchCSpin(LOW);
-    SPI.transfer((data >> 16) & 0xFF);
-    SPI.transfer((data >>  8) & 0xFF);
-    SPI.transfer(data & 0xFF);
-    SPI.endTransaction();
-  }
-  switchCSpin(HIGH);
+  uint8_t buf[3] = {
+    static_cast<uint8_t>(data >> 16),
+    static_cast<uint8_t>(data >>  8),
+    static_cast<uint8_t>(data >>  0)
+  };
+  transfer(buf, 3);
 }
 
 void TMC2660Stepper::begin() {
@@ -9,8 +9,12 @@ TMC5130Stepper::TMC5130Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint1
 TMC5130Stepper::TMC5130Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link) :
   TMC2160Stepper(pinCS, default_RS, pinMOSI, pinMISO, pinSCK, link)
   { defaults(); }
+TMC5130Stepper::TMC5130Stepper(SPIChain &chain, uint16_t pinCS, float RS, int8_t link) :
+  TMC2160Stepper(chain, pinCS, RS, link)
+  { defaults(); }
 
 void TMC5130Stepper::begin() {
+  Session session(*this);
   TMC2160Stepper::begin();
 
   XTARGET(0);
@@ -35,40 +39,90 @@ void TMC5130Stepper::defaults() {
   PWMCONF_register.sr = 0x00050480;
 }
 
-void TMC5130Stepper::push() {
-    IHOLD_IRUN(IHOLD_IRUN_register.sr);
-    TPOWERDOWN(TPOWERDOWN_register.sr);
-    TPWMTHRS(TPWMTHRS_register.sr);
-    GCONF(GCONF_register.sr);
-    TCOOLTHRS(TCOOLTHRS_register.sr);
-    THIGH(THIGH_register.sr);
-    XDIRECT(XDIRECT_register.sr);
-    VDCMIN(VDCMIN_register.sr);
-    CHOPCONF(CHOPCONF_register.sr);
-    COOLCONF(COOLCONF_register.sr);
-    DCCTRL(DCCTRL_register.sr);
-    PWMCONF(PWMCONF_register.sr);
-    ENCM_CTRL(ENCM_CTRL_register.sr);
-    DRV_CONF(DRV_CONF_register.sr);
-    SLAVECONF(SLAVECONF_register.sr);
-    TMC_OUTPUT(OUTPUT_register.sr);
-    X_COMPARE(X_COMPARE_register.sr);
-    RAMPMODE(RAMPMODE_register.sr);
-    XACTUAL(XACTUAL_register.sr);
-    VSTART(VSTART_register.sr);
-    A1(A1_register.sr);
-    V1(V1_register.sr);
-    AMAX(AMAX_register.sr);
-    VMAX(VMAX_register.sr);
-    DMAX(DMAX_register.sr);
-    D1(D1_register.sr);
-    VSTOP(VSTOP_register.sr);
-    TZEROWAIT(TZEROWAIT_register.sr);
-    SW_MODE(SW_MODE_register.sr);
-    ENCMODE(ENCMODE_register.sr);
-    ENC_CONST(ENC_CONST_register.sr);
+bool TMC5130Stepper::shadow(uint8_t address, uint32_t &value) {
+  switch(address) {
+    case XTARGET_t::address: return false; // XDIRECT on TMC2130
+    SHADOW_REG(SLAVECONF);
+    SHADOW_REG(OUTPUT);
+    SHADOW_REG(X_COMPARE);
+    SHADOW_REG(RAMPMODE);
+    SHADOW_REG(VSTART);
+    SHADOW_REG(A1);
+    SHADOW_REG(V1);
+    SHADOW_REG(AMAX);
+    SHADOW_REG(VMAX);
+    SHADOW_REG(DMAX);
+    SHADOW_REG(D1);
+    SHADOW_REG(VSTOP);
+    SHADOW_REG(TZEROWAIT);
+    SHADOW_REG(SW_MODE);
+    SHADOW_REG(ENCMODE);
+    SHADOW_REG(ENC_CONST);
+    SHADOW_REG(TMC2130Stepper::PWMCONF); // Setter inherited from TMC2130
+  }
+  return TMC2160Stepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC5130_registers[] REGISTER_MAP_STORAGE = {
+  { 0x00, 18, TMC_access::RW,                 0x00000000 }, // GCONF
+  { 0x01,  3, TMC_access::RC | TMC_access::V, 0x00000000 }, // GSTAT
+  { 0x02,  8, TMC_access::R | TMC_access::V,  0x00000000 }, // IFCNT
+  { 0x03, 12, TMC_access::W,                  0x00000000 }, // SLAVECONF
+  { 0x04, 32, TMC_access::RW | TMC_access::V, 0x00000000 }, // IOIN / OUTPUT
+  { 0x05, 32, TMC_access::W,                  0x00000000 }, // X_COMPARE
+  { 0x10, 20, TMC_access::W,                  0x00000000 }, // IHOLD_IRUN
+  { 0x11,  8, TMC_access::W,                  0x00000000 }, // TPOWERDOWN
+  { 0x12, 20, TMC_access::R | TMC_access::V,  0x00000000 }, // TSTEP
+  { 0x13, 20, TMC_access::W,                  0x00000000 }, // TPWMTHRS
+  { 0x14, 20, TMC_access::W,                  0x00000000 }, // TCOOLTHRS
+  { 0x15, 20, TMC_access::W,                  0x00000000 }, // THIGH
+  { 0x20,  2, TMC_access::RW,                 0x00000000 }, // RAMPMODE
+  { 0x21, 32, TMC_access::RW | TMC_access::V, 0x00000000 }, // XACTUAL
+  { 0x22, 24, TMC_access::R | TMC_access::V,  0x00000000 }, // VACTUAL
+  { 0x23, 18, TMC_access::W,                  0x00000000 }, // VSTART
+  { 0x24, 16, TMC_access::W,                  0x00000000 }, // A1
+  { 0x25, 20, TMC_access::W,                  0x00000000 }, // V1
+  { 0x26, 16, TMC_access::W,                  0x00000000 }, // AMAX
+  { 0x27, 23, TMC_access::W,                  0x00000000 }, // VMAX
+  { 0x28, 16, TMC_access::W,                  0x00000000 }, // DMAX
+  { 0x2A, 16, TMC_access::W,                  0x00000000 }, // D1
+  { 0x2B, 18, TMC_access::W,                  0x00000000 }, // VSTOP
+  { 0x2C, 16, TMC_access::W,                  0x00000000 }, // TZEROWAIT
+  { 0x2D, 32, TMC_access::RW,                 0x00000000 }, // XTARGET
+  { 0x33, 23, TMC_access::W,                  0x00000000 }, // VDCMIN
+  { 0x34, 12, TMC_access::RW,                 0x00000000 }, // SW_MODE
+  { 0x35, 14, TMC_access::RC | TMC_access::V, 0x00000000 }, // RAMP_STAT
+  { 0x36, 32, TMC_access::R | TMC_access::V,  0x00000000 }, // XLATCH
+  { 0x38, 11, TMC_access::RW,                 0x00000000 }, // ENCMODE
+  { 0x39, 32, TMC_access::RW | TMC_access::V, 0x00000000 }, // X_ENC
+  { 0x3A, 32, TMC_access::W,                  0x00010000 }, // ENC_CONST
+  { 0x3B,  1, TMC_access::RC | TMC_access::V, 0x00000000 }, // ENC_STATUS
+  { 0x3C, 32, TMC_access::R | TMC_access::V,  0x00000000 }, // ENC_LATCH
+  { 0x60, 32, TMC_access::W,                  0xAAAAB554 }, // MSLUT0
+  { 0x61, 32, TMC_access::W,                  0x4A9554AA }, // MSLUT1
+  { 0x62, 32, TMC_access::W,                  0x24492929 }, // MSLUT2
+  { 0x63, 32, TMC_access::W,                  0x10104222 }, // MSLUT3
+  { 0x64, 32, TMC_access::W,                  0xFBFFFFFF }, // MSLUT4
+  { 0x65, 32, TMC_access::W,                  0xB5BB777D }, // MSLUT5
+  { 0x66, 32, TMC_access::W,                  0x49295556 }, // MSLUT6
+  { 0x67, 32, TMC_access::W,                  0x00404222 }, // MSLUT7
+  { 0x68, 32, TMC_access::W,                  0xFFFF8056 }, // MSLUTSEL
+  { 0x69, 24, TMC_access::W,                  0x00F70000 }, // MSLUTSTART
+  { 0x6A, 10, TMC_access::R | TMC_access::V,  0x00000000 }, // MSCNT
+  { 0x6B, 25, TMC_access::R | TMC_access::V,  0x00000000 }, // MSCURACT
+  { 0x6C, 32, TMC_access::RW,                 0x00000000 }, // CHOPCONF
+  { 0x6D, 25, TMC_access::W,                  0x00000000 }, // COOLCONF
+  { 0x6E, 24, TMC_access::W,                  0x00000000 }, // DCCTRL
+  { 0x6F, 32, TMC_access::R | TMC_access::V,  0x00000000 }, // DRV_STATUS
+  { 0x70, 22, TMC_access::W,                  0x00050480 }, // PWMCONF
+  { 0x71,  8, TMC_access::R | TMC_access::V,  0x00000000 }, // PWM_SCALE
+  { 0x72,  2, TMC_access::W,                  0x00000000 }, // ENCM_CTRL
+  { 0x73, 20, TMC_access::R | TMC_access::V,  0x00000000 }, // LOST_STEPS
+};
+
+TMC_register_map_t TMC5130Stepper::register_map() { return REGISTER_MAP(TMC5130_registers); }
+
 ///////////////////////////////////////////////////////////////////////////////////////
 // R: IFCNT
 uint8_t TMC5130Stepper::IFCNT() { return read(IFCNT_t::address); }
@@ -84,6 +138,7 @@ void TMC5130Stepper::SLAVECONF(uint16_t input) {
 uint32_t  TMC5130Stepper::IOIN() {
   return read(TMC5130_n::IOIN_t::address);
 }
+TMC5130_n::IOIN_t TMC5130Stepper::ioin_snapshot() { TMC5130_n::IOIN_t r{0}; r.sr = IOIN(); return r; }
 bool    TMC5130Stepper::refl_step()      { TMC5130_n::IOIN_t r{0}; r.sr = IOIN(); return r.refl_step; }
 bool    TMC5130Stepper::refr_dir()       { TMC5130_n::IOIN_t r{0}; r.sr = IOIN(); return r.refr_dir; }
 bool    TMC5130Stepper::encb_dcen_cfg4() { TMC5130_n::IOIN_t r{0}; r.sr = IOIN(); return r.encb_dcen_cfg4; }
@@ -109,16 +164,16 @@ void TMC5130Stepper::X_COMPARE(uint32_t input) {
 }
 ///////////////////////////////////////////////////////////////////////////////////////
 // RW: RAMPMODE
-uint8_t TMC5130Stepper::RAMPMODE() { return read(RAMPMODE_register.address); }
+uint8_t TMC5130Stepper::RAMPMODE() { return read_cached(RAMPMODE_register); }
 void TMC5130Stepper::RAMPMODE(uint8_t input) {
   RAMPMODE_register.sr = input;
   write(RAMPMODE_register.address, RAMPMODE_register.sr);
 }
 ///////////////////////////////////////////////////////////////////////////////////////
 // RW: XACTUAL
-int32_t TMC5130Stepper::XACTUAL() { return read(XACTUAL_register.address); }
+int32_t TMC5130Stepper::XACTUAL() { return read(XACTUAL_t::address); }
 void TMC5130Stepper::XACTUAL(int32_t input) {
-  write(XACTUAL_register.address, input);
+  write(XACTUAL_t::address, input);
 }
 ///////////////////////////////////////////////////////////////////////////////////////
 // R: VACTUAL
@@ -9,6 +9,9 @@ TMC5160Stepper::TMC5160Stepper(uint16_t pinCS, float RS, uint16_t pinMOSI, uint1
 TMC5160Stepper::TMC5160Stepper(uint16_t pinCS, uint16_t pinMOSI, uint16_t pinMISO, uint16_t pinSCK, int8_t link) :
   TMC5130Stepper(pinCS, default_RS, pinMOSI, pinMISO, pinSCK, link)
   { defaults(); }
+TMC5160Stepper::TMC5160Stepper(SPIChain &chain, uint16_t pinCS, float RS, int8_t link) :
+  TMC5130Stepper(chain, pinCS, RS, link)
+  { defaults(); }
 
 void TMC5160Stepper::defaults() {
   SHORT_CONF_register.s2vs_level = 6;
@@ -35,45 +38,85 @@ void TMC5160Stepper::defaults() {
   //MSLUTSTART_register.start_sin = 0;
   //MSLUTSTART_register.start_sin90 = 247;
   CHOPCONF_register.sr = 0x10410150;
-  PWMCONF_register.sr = 0xC40C001E;
+  PWMCONF_2160_register.sr = 0xC40C001E;
 }
 
-void TMC5160Stepper::push() {
-    IHOLD_IRUN(IHOLD_IRUN_register.sr);
-    TPOWERDOWN(TPOWERDOWN_register.sr);
-    TPWMTHRS(TPWMTHRS_register.sr);
-    GCONF(GCONF_register.sr);
-    TCOOLTHRS(TCOOLTHRS_register.sr);
-    THIGH(THIGH_register.sr);
-    XDIRECT(XDIRECT_register.sr);
-    VDCMIN(VDCMIN_register.sr);
-    CHOPCONF(CHOPCONF_register.sr);
-    COOLCONF(COOLCONF_register.sr);
-    DCCTRL(DCCTRL_register.sr);
-    PWMCONF(PWMCONF_register.sr);
-    SHORT_CONF(SHORT_CONF_register.sr);
-    DRV_CONF(DRV_CONF_register.sr);
-    GLOBAL_SCALER(GLOBAL_SCALER_register.sr);
-    SLAVECONF(SLAVECONF_register.sr);
-    TMC_OUTPUT(OUTPUT_register.sr);
-    X_COMPARE(X_COMPARE_register.sr);
-    RAMPMODE(RAMPMODE_register.sr);
-    XACTUAL(XACTUAL_register.sr);
-    VSTART(VSTART_register.sr);
-    A1(A1_register.sr);
-    V1(V1_register.sr);
-    AMAX(AMAX_register.sr);
-    VMAX(VMAX_register.sr);
-    DMAX(DMAX_register.sr);
-    D1(D1_register.sr);
-    VSTOP(VSTOP_register.sr);
-    TZEROWAIT(TZEROWAIT_register.sr);
-    SW_MODE(SW_MODE_register.sr);
-    ENCMODE(ENCMODE_register.sr);
-    ENC_CONST(ENC_CONST_register.sr);
-	ENC_DEVIATION(ENC_DEVIATION_register.sr);
+bool TMC5160Stepper::shadow(uint8_t address, uint32_t &value) {
+	switch(address) {
+		SHADOW_REG(ENC_DEVIATION);
+		SHADOW_REG(PWMCONF_2160);
+	}
+	return TMC5130Stepper::shadow(address, value);
 }
 
+// Address, implemented bits, access, reset value
+static constexpr TMC_register_t TMC5160_registers[] REGISTER_MAP_STORAGE = {
+	{ 0x00, 18, TMC_access::RW,                   0x00000000 }, // GCONF
+	{ 0x01,  3, TMC_access::RC | TMC_access::V,   0x00000000 }, // GSTAT
+	{ 0x02,  8, TMC_access::R | TMC_access::V,    0x00000000 }, // IFCNT
+	{ 0x03, 12, TMC_access::W,                    0x00000000 }, // SLAVECONF
+	{ 0x04, 32, TMC_access::RW | TMC_access::V,   0x00000000 }, // IOIN / OUTPUT
+	{ 0x05, 32, TMC_access::W,                    0x00000000 }, // X_COMPARE
+	{ 0x06, 14, TMC_access::W,                    0x00000000 }, // OTP_PROG
+	{ 0x07,  8, TMC_access::R,                    0x00000000 }, // OTP_READ
+	{ 0x08,  5, TMC_access::RW | TMC_access::OTP, 0x00000000 }, // FACTORY_CONF
+	{ 0x09, 19, TMC_access::W,                    0x00010606 }, // SHORT_CONF
+	{ 0x0A, 22, TMC_access::W,                    0x00080400 }, // DRV_CONF
+	{ 0x0B,  8, TMC_access::W,                    0x00000000 }, // GLOBAL_SCALER
+	{ 0x0C, 16, TMC_access::R,                    0x00000000 }, // OFFSET_READ
+	{ 0x10, 20, TMC_access::W,                    0x00000000 }, // IHOLD_IRUN
+	{ 0x11,  8, TMC_access::W,                    0x0000000A }, // TPOWERDOWN
+	{ 0x12, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // TSTEP
+	{ 0x13, 20, TMC_access::W,                    0x00000000 }, // TPWMTHRS
+	{ 0x14, 20, TMC_access::W,                    0x00000000 }, // TCOOLTHRS
+	{ 0x15, 20, TMC_access::W,                    0x00000000 }, // THIGH
+	{ 0x20,  2, TMC_access::RW,                   0x00000000 }, // RAMPMODE
+	{ 0x21, 32, TMC_access::RW | TMC_access::V,   0x00000000 }, // XACTUAL
+	{ 0x22, 24, TMC_access::R | TMC_access::V,    0x00000000 }, // VACTUAL
+	{ 0x23, 18, TMC_access::W,                    0x00000000 }, // VSTART
+	{ 0x24, 16, TMC_access::W,                    0x00000000 }, // A1
+	{ 0x25, 20, TMC_access::W,                    0x00000000 }, // V1
+	{ 0x26, 16, TMC_access::W,                    0x00000000 }, // AMAX
+	{ 0x27, 23, TMC_access::W,                    0x00000000 }, // VMAX
+	{ 0x28, 16, TMC_access::W,                    0x00000000 }, // DMAX
+	{ 0x2A, 16, TMC_access::W,                    0x00000000 }, // D1
+	{ 0x2B, 18, TMC_access::W,                    0x00000000 }, // VSTOP
+	{ 0x2C, 16, TMC_access::W,                    0x00000000 }, // TZEROWAIT
+	{ 0x2D, 32, TMC_access::RW,                   0x00000000 }, // XTARGET
+	{ 0x33, 23, TMC_access::W,                    0x00000000 }, // VDCMIN
+	{ 0x34, 12, TMC_access::RW,                   0x00000000 }, // SW_MODE
+	{ 0x35, 14, TMC_access::RC | TMC_access::V,   0x00000000 }, // RAMP_STAT
+	{ 0x36, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // XLATCH
+	{ 0x38, 11, TMC_access::RW,                   0x00000000 }, // ENCMODE
+	{ 0x39, 32, TMC_access::RW | TMC_access::V,   0x00000000 }, // X_ENC
+	{ 0x3A, 32, TMC_access::W,                    0x00010000 }, // ENC_CONST
+	{ 0x3B,  2, TMC_access::RC | TMC_access::V,   0x00000000 }, // ENC_STATUS
+	{ 0x3C, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // ENC_LATCH
+	{ 0x3D, 20, TMC_access::W,                    0x00000000 }, // ENC_DEVIATION
+	{ 0x60, 32, TMC_access::W,                    0xAAAAB554 }, // MSLUT0
+	{ 0x61, 32, TMC_access::W,                    0x4A9554AA }, // MSLUT1
+	{ 0x62, 32, TMC_access::W,                    0x24492929 }, // MSLUT2
+	{ 0x63, 32, TMC_access::W,                    0x10104222 }, // MSLUT3
+	{ 0x64, 32, TMC_access::W,                    0xFBFFFFFF }, // MSLUT4
+	{ 0x65, 32, TMC_access::W,                    0xB5BB777D }, // MSLUT5
+	{ 0x66, 32, TMC_access::W,                    0x49295556 }, // MSLUT6
+	{ 0x67, 32, TMC_access::W,                    0x00404222 }, // MSLUT7
+	{ 0x68, 32, TMC_access::W,                    0xFFFF8056 }, // MSLUTSEL
+	{ 0x69, 24, TMC_access::W,                    0x00F70000 }, // MSLUTSTART
+	{ 0x6A, 10, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCNT
+	{ 0x6B, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // MSCURACT
+	{ 0x6C, 32, TMC_access::RW,                   0x10410150 }, // CHOPCONF
+	{ 0x6D, 25, TMC_access::W,                    0x00000000 }, // COOLCONF
+	{ 0x6E, 24, TMC_access::W,                    0x00000000 }, // DCCTRL
+	{ 0x6F, 32, TMC_access::R | TMC_access::V,    0x00000000 }, // DRV_STATUS
+	{ 0x70, 32, TMC_access::W,                    0xC40C001E }, // PWMCONF
+	{ 0x71, 25, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_SCALE
+	{ 0x72, 24, TMC_access::R | TMC_access::V,    0x00000000 }, // PWM_AUTO
+	{ 0x73, 20, TMC_access::R | TMC_access::V,    0x00000000 }, // LOST_STEPS
+};
+
+TMC_register_map_t TMC5160Stepper::register_map() { return REGISTER_MAP(TMC5160_registers); }
+
 // R+WC: ENC_STATUS
 uint8_t TMC5160Stepper::ENC_STATUS() { return read(ENC_STATUS_t::address); }
 void TMC5160Stepper::ENC_STATUS(uint8_t input) {
@@ -91,5 +134,6 @@ void TMC5160Stepper::ENC_DEVIATION(uint32_t input) {
 uint32_t TMC5160Stepper::PWM_AUTO() {
 	return read(PWM_AUTO_t::address);
 }
+PWM_AUTO_t TMC5160Stepper::pwm_auto_snapshot() { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r; }
 uint8_t TMC5160Stepper::pwm_ofs_auto()  { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r.pwm_ofs_auto; }
 uint8_t TMC5160Stepper::pwm_grad_auto() { PWM_AUTO_t r{0}; r.sr = PWM_AUTO(); return r.pwm_grad_auto; }
@@ -17,25 +17,40 @@
   CS = 26
 */
 
-uint16_t TMCStepper::cs2rms(uint8_t CS) {
-  return (float)(CS+1)/32.0 * (vsense() ? 0.180 : 0.325)/(Rsense+0.02) / 1.41421 * 1000;
-}
-
-void TMCStepper::rms_current(uint16_t mA) {
+uint8_t TMC_current::cs(uint16_t mA, float Rsense, bool &vsense) {
   uint8_t CS = 32.0*1.41421*mA/1000.0*(Rsense+0.02)/0.325 - 1;
   // If Current Scale is too low, turn on high sensitivity R_sense and calculate again
-  if (CS < 16) {
-    vsense(true);
+  vsense = CS < 16;
+  if (vsense) {
     CS = 32.0*1.41421*mA/1000.0*(Rsense+0.02)/0.180 - 1;
-  } else { // If CS >= 16, turn off high_sense_r
-    vsense(false);
   }
 
   if (CS > 31)
     CS = 31;
+  return CS;
+}
+
+uint16_t TMC_current::rms(uint8_t CS, float Rsense, bool vsense) {
+  return (float)(CS+1)/32.0 * (vsense ? 0.180 : 0.325)/(Rsense+0.02) / 1.41421 * 1000;
+}
+
+uint16_t TMCStepper::cs2rms(uint8_t CS) {
+  return TMC_current::rms(CS, Rsense, vsense());
+}
+
+void TMCStepper::rms_current(uint16_t mA) {
+  constexpr uint8_t CHOPCONF_address = 0x6C;
+  constexpr uint32_t vsense_bm = 1UL << 17; // Same position in every CHOPCONF layout
 
-  irun(CS);
-  ihold(CS*holdMultiplier);
+  bool high_sense = false;
+  const uint8_t CS = TMC_current::cs(mA, Rsense, high_sense);
+
+  Session session(*this);
+  uint32_t chopconf = 0;
+  shadow(CHOPCONF_address, chopconf);
+  if (!in_sync(CHOPCONF_address) || bool(chopconf & vsense_bm) != high_sense)
+    vsense(high_sense);
+  current_scale(CS);
   //val_mA = mA;
 }
 void TMCStepper::rms_current(uint16_t mA, float mult) {
@@ -47,6 +62,14 @@ uint16_t TMCStepper::rms_current() {
   return cs2rms(irun());
 }
 
+// Set irun and ihold with a single IHOLD_IRUN write
+void TMCStepper::current_scale(uint8_t CS) {
+  IHOLD_IRUN_t r = IHOLD_IRUN_register;
+  r.irun = CS;
+  r.ihold = CS*holdMultiplier;
+  IHOLD_IRUN(r.sr);
+}
+
 uint8_t TMCStepper::test_connection() {
   uint32_t drv_status = DRV_STATUS();
   switch (drv_status) {
@@ -56,6 +79,243 @@ uint8_t TMCStepper::test_connection() {
   }
 }
 
+void TMCStepper::cache_mode(bool enable) {
+  cache_enabled = enable;
+}
+
+void TMCStepper::invalidate_cache() {
+  for (uint8_t i = 0; i < sizeof(synced); i++) {
+    synced[i] = 0;
+  }
+}
+
+void TMCStepper::batch_mode(bool enable) {
+  if (!enable) commit();
+  batch_enabled = enable;
+}
+
+// Write every register that was changed while batching, once
+void TMCStepper::commit() {
+  uint8_t select[sizeof(write_pending)];
+  for (uint8_t i = 0; i < sizeof(write_pending); i++) {
+    select[i] = write_pending[i];
+    write_pending[i] = 0;
+  }
+  write_shadows(select);
+}
+
+// Write every register of the register map that has a shadow copy
+void TMCStepper::push() {
+  uint8_t select[sizeof(synced)];
+  pushable(select);
+  for (uint8_t i = 0; i < sizeof(synced); i++) {
+    select[i] |= write_pending[i];
+    write_pending[i] = 0;
+  }
+  write_shadows(select);
+}
+
+/**
+ *  Like push(), but skips registers that were written or read back since
+ *  the last detected reset. After a reset every register is unknown and
+ *  gets written again, then GSTAT.reset is cleared so that the next reset
+ *  can be told apart. drv_err and uv_cp are left to the application.
+ */
+void TMCStepper::push_changed() {
+  uint8_t select[sizeof(synced)];
+  pushable(select);
+  for (uint8_t i = 0; i < sizeof(synced); i++) {
+    select[i] = (select[i] & ~synced[i]) | write_pending[i];
+    write_pending[i] = 0;
+  }
+  write_shadows(select);
+  if (reset_pending) {
+    reset_pending = false;
+    write(GSTAT_t::address, 0b001);
+  }
+}
+
+// Shadow registers can't be trusted after a driver reset
+void TMCStepper::reset_detected() {
+  invalidate_cache();
+  reset_pending = true;
+}
+
+// Writable registers of the register map, except those trimmed in OTP
+void TMCStepper::pushable(uint8_t select[]) {
+  for (uint8_t i = 0; i < sizeof(synced); i++) {
+    select[i] = 0;
+  }
+  const uint8_t count = register_count();
+  for (uint8_t i = 0; i < count; i++) {
+    const TMC_register_t reg = register_info(i);
+    if (reg.writable() && !(reg.access & TMC_access::OTP))
+      select[i>>3] |= 1<<(i&7);
+  }
+}
+
+/**
+ *  Map order puts the global configuration and the ramp parameters
+ *  first. CHOPCONF follows because a nonzero toff enables the power
+ *  stage, then RAMPMODE and XTARGET, which may start a move.
+ *  Registers without a shadow copy are skipped. XTARGET has none on
+ *  the TMC5130/5160; setting it commits the pending writes first, so
+ *  it lands after them anyway.
+ */
+void TMCStepper::write_shadows(const uint8_t select[]) {
+  static constexpr uint8_t last[] = {
+    0x6C, // CHOPCONF
+    0x20, // RAMPMODE
+    0x2D  // XTARGET
+  };
+  const bool batching = batch_enabled;
+  batch_enabled = false;
+
+  Session session(*this);
+  const TMC_register_map_t map = register_map();
+  for (uint8_t i = 0; i < map.count; i++) {
+    const uint8_t address = map.address(i);
+    if (!(select[i>>3] & (1<<(i&7)))) continue;
+    bool deferred = false;
+    for (uint8_t l : last) deferred |= address == l;
+    uint32_t value = 0;
+    if (!deferred && shadow(address, value)) write(address, value);
+  }
+  for (uint8_t address : last) {
+    const int8_t i = register_index(address);
+    uint32_t value = 0;
+    if (i >= 0 && (select[i>>3] & (1<<(i&7))) && shadow(address, value))
+      write(address, value);
+  }
+
+  batch_enabled = batching;
+}
+
+TMC_register_t TMCStepper::register_info(uint8_t index) {
+  const TMC_register_map_t map = register_map();
+  TMC_register_t info{0, 0, 0, 0};
+  if (index >= map.count) return info;
+  #if defined(ARDUINO_ARCH_AVR)
+    memcpy_P(&info, &map.entries[index], sizeof(info));
+  #else
+    info = map.entries[index];
+  #endif
+  return info;
+}
+
+bool TMCStepper::find_register(uint8_t address, TMC_register_t &info) {
+  const int8_t index = register_index(address);
+  if (index < 0) return false;
+  info = register_info(index);
+  return true;
+}
+
+// Position in the register map, -1 if the chip has no such register
+int8_t TMCStepper::register_index(uint8_t address) {
+  const TMC_register_map_t map = register_map();
+  uint8_t low = 0, high = map.count;
+  while (low < high) {
+    const uint8_t mid = (low + high) / 2;
+    const uint8_t found = map.address(mid);
+    if (found == address) return mid;
+    if (found < address) low = mid + 1;
+    else high = mid;
+  }
+  return -1;
+}
+
+bool TMCStepper::get_flag(const uint8_t flags[], uint8_t address) {
+  const int8_t index = register_index(address);
+  return index >= 0 && (flags[index>>3] & (1<<(index&7)));
+}
+
+void TMCStepper::set_flag(uint8_t flags[], uint8_t address, bool value) {
+  const int8_t index = register_index(address);
+  if (index < 0) return;
+  if (value) flags[index>>3] |= 1<<(index&7);
+  else flags[index>>3] &= ~(1<<(index&7));
+}
+
+/**
+ *  Fills out[] with one value per register map entry. Write only
+ *  registers and latched flag registers (GSTAT, RAMP_STAT, ENC_STATUS),
+ *  which are not read so that no event gets lost, report their shadow
+ *  copy, or the reset value if the library keeps none. So do registers
+ *  whose read fails.
+ */
+void TMCStepper::dump(uint32_t out[]) {
+  Session session(*this);
+  const uint8_t count = register_count();
+  for (uint8_t i = 0; i < count; i++) {
+    const TMC_register_t reg = register_info(i);
+    out[i] = reg.reset;
+    shadow(reg.address, out[i]);
+    if (!reg.readable() || (reg.access & TMC_access::C)) continue;
+    const uint32_t value = read(reg.address);
+    if (!read_failed()) out[i] = value;
+  }
+}
+
+/**
+ *  Reads back the registers that keep their written value and compares
+ *  them with the shadow copies. Matching registers are marked as synced,
+ *  the others get written by the next push_changed(). Registers that
+ *  fail to read are skipped.
+ *  Returns the number of registers that differ.
+ */
+uint8_t TMCStepper::diff() {
+  Session session(*this);
+  uint8_t differ = 0;
+  const uint8_t count = register_count();
+  for (uint8_t i = 0; i < count; i++) {
+    const TMC_register_t reg = register_info(i);
+    if (!reg.readable() || !reg.writable() || reg.changing()) continue;
+    uint32_t value = 0;
+    if (dirty(reg.address) || !shadow(reg.address, value)) continue;
+    const uint32_t actual = read(reg.address);
+    if (read_failed()) continue; // Unknown, keep the previous state
+    if ((actual ^ value) & reg.mask()) {
+      synced[i>>3] &= ~(1<<(i&7));
+      differ++;
+    }
+    else
+      synced[i>>3] |= 1<<(i&7);
+  }
+  return differ;
+}
+
+/**
+ *  Returns true when the write was held back for commit().
+ *  Registers without a shadow copy are commands; pending
+ *  writes go out first so that the program order is kept.
+ */
+bool TMCStepper::defer_write(uint8_t address) {
+  if (!batch_enabled) return false;
+
+  uint32_t value = 0;
+  if (!shadow(address, value)) {
+    commit();
+    return false;
+  }
+  const int8_t index = register_index(address);
+  if (index < 0) {
+    commit();
+    return false;
+  }
+  write_pending[index>>3] |= 1<<(index&7);
+  synced[index>>3] &= ~(1<<(index&7));
+  return true;
+}
+
+bool TMCStepper::shadow(uint8_t address, uint32_t &value) {
+  switch(address) {
+    SHADOW_REG(IHOLD_IRUN);
+    SHADOW_REG(TPOWERDOWN);
+    SHADOW_REG(TPWMTHRS);
+  }
+  return false;
+}
+
 void TMCStepper::hysteresis_end(int8_t value) { hend(value+3); }
 int8_t TMCStepper::hysteresis_end() { return hend()-3; };
 
@@ -113,7 +373,14 @@ uint8_t TMCStepper::blank_time() {
 
 ///////////////////////////////////////////////////////////////////////////////////////
 // R+C: GSTAT
-uint8_t TMCStepper::GSTAT()  { return read(GSTAT_t::address); }
+uint8_t TMCStepper::GSTAT()  {
+  GSTAT_t r;
+  r.sr = read(GSTAT_t::address);
+  // Registers are back to their power on defaults
+  if (r.reset) reset_detected();
+  return r.sr;
+}
+GSTAT_t TMCStepper::gstat_snapshot() { GSTAT_t r{0}; r.sr = GSTAT(); return r; }
 void  TMCStepper::GSTAT(uint8_t){ write(GSTAT_t::address, 0b111); }
 bool  TMCStepper::reset()    { GSTAT_t r; r.sr = GSTAT(); return r.reset; }
 bool  TMCStepper::drv_err()  { GSTAT_t r; r.sr = GSTAT(); return r.drv_err; }
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ *  Current scale math shared by the driver classes and TMCDriver.
+ *  The equations are given in TMCStepper.cpp and TMC2160Stepper.cpp.
+ */
+namespace TMC_current {
+	// Full scale voltage 0.325V, or 0.180V when vsense is set
+	uint8_t cs(uint16_t mA, float Rsense, bool &vsense);
+	uint16_t rms(uint8_t CS, float Rsense, bool vsense);
+
+	// TMC2160 and TMC5160, full scale 0.325V trimmed by GLOBAL_SCALER (0 is 256)
+	uint8_t scaled_cs(uint16_t mA, float Rsense, uint8_t &scaler);
+	uint16_t scaled_rms(uint8_t CS, float Rsense, uint8_t scaler);
+}
@@ -3,3 +3,7 @@
 #define DEBUG_PRINT(CFG, VAL) Serial.print(CFG); Serial.print('('); Serial.print(VAL, HEX); Serial.println(')')
 //#define WRITE_REG(R) write(R##_register.address, R##_register.sr)
 //#define READ_REG(R) read(R##_register.address)
+#define SHADOW_REG(R) case decltype(R##_register)::address: value = R##_register.sr; return true
+
+// Sets the bitfield at OFFSET of the shadow register R to B and writes the register
+#define WRITE_FIELD(R, OFFSET, WIDTH) set_field<field<decltype(R##_register), OFFSET, WIDTH>>(R##_register, B)
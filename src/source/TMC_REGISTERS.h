@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ARDUINO_ARCH_AVR)
+	#include <avr/pgmspace.h>
+	#define REGISTER_MAP_STORAGE PROGMEM
+#else
+	#define REGISTER_MAP_STORAGE
+#endif
+
+namespace TMC_access {
+	constexpr uint8_t R		= 0b00001;	// Reads return the register content
+	constexpr uint8_t W		= 0b00010;	// Writable
+	constexpr uint8_t C		= 0b00100;	// Write 1 to clear flags
+	constexpr uint8_t V		= 0b01000;	// Changed by the device, or reads return another register
+	constexpr uint8_t OTP	= 0b10000;	// Loaded from OTP at power up, not written by push()
+	constexpr uint8_t RW	= R | W;
+	constexpr uint8_t RC	= R | C;
+}
+
+/**
+ *  One entry of a chip register map.
+ *  Maps are listed in ascending address order.
+ */
+struct TMC_register_t {
+	uint8_t address;
+	uint8_t width;		// Implemented bits, starting at bit 0
+	uint8_t access;		// TMC_access flags
+	uint32_t reset;		// Power on value
+
+	constexpr bool readable() const { return access & TMC_access::R; }
+	constexpr bool writable() const { return access & TMC_access::W; }
+	constexpr bool changing() const { return access & TMC_access::V; }
+	constexpr uint32_t mask() const { return width < 32 ? (1UL << width) - 1 : 0xFFFFFFFF; }
+};
+
+// Longest register map, TMC5160 has 62 entries. Sizes the per-register flags.
+constexpr uint8_t TMC_MAX_REGISTERS = 64;
+
+struct TMC_register_map_t {
+	const TMC_register_t *entries;
+	uint8_t count;
+
+	uint8_t address(uint8_t index) const {
+		#if defined(ARDUINO_ARCH_AVR)
+			return pgm_read_byte(&entries[index].address);
+		#else
+			return entries[index].address;
+		#endif
+	}
+};
+
+template<size_t N>
+TMC_register_map_t make_register_map(const TMC_register_t (&entries)[N]) {
+	static_assert(N <= TMC_MAX_REGISTERS, "Register map longer than TMC_MAX_REGISTERS");
+	return TMC_register_map_t{ entries, N };
+}
+
+#define REGISTER_MAP(MAP) make_register_map(MAP)
+
+/**
+ *  Position of a bitfield in a register, known at compile time, so that
+ *  setters update the shadow register with a constant mask and shift.
+ *  field<CHOPCONF_t, 0, 4> is toff.
+ */
+template<typename REG, uint8_t OFFSET, uint8_t WIDTH>
+struct field {
+	static constexpr uint8_t address = REG::address;
+	static constexpr uint8_t offset = OFFSET;
+	static constexpr uint32_t mask = (WIDTH < 32 ? (1UL << WIDTH) - 1 : 0xFFFFFFFF) << OFFSET;
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ *  Chip descriptions for the TMCDriver front end. Shadow defaults match
+ *  defaults() of the matching TMC*Stepper class, the begin_* settings
+ *  match its begin().
+ */
+struct TMC2130_chip {
+	typedef ::CHOPCONF_t CHOPCONF_t;
+	static constexpr bool global_scaler = false;
+	static constexpr bool begin_chopper = true; // toff(8), tbl(1)
+	static constexpr bool begin_ramp = false; // XTARGET and XACTUAL 0
+	static constexpr uint32_t GCONF_begin = 0;
+	static constexpr uint32_t GCONF_reset = 0x00000000,
+														IHOLD_IRUN_reset = 0x00000000,
+														CHOPCONF_reset = 0x00000000,
+														PWMCONF_reset = 0x00050480;
+};
+struct TMC2160_chip {
+	typedef ::CHOPCONF_t CHOPCONF_t;
+	static constexpr bool global_scaler = true;
+	static constexpr bool begin_chopper = true;
+	static constexpr bool begin_ramp = false;
+	static constexpr uint32_t GCONF_begin = 0;
+	static constexpr uint32_t GCONF_reset = 0x00000000,
+														IHOLD_IRUN_reset = 0x00000000,
+														CHOPCONF_reset = 0x10410150,
+														PWMCONF_reset = 0xC40C001E;
+};
+struct TMC5130_chip {
+	typedef ::CHOPCONF_t CHOPCONF_t;
+	static constexpr bool global_scaler = false;
+	static constexpr bool begin_chopper = true;
+	static constexpr bool begin_ramp = true;
+	static constexpr uint32_t GCONF_begin = 0;
+	static constexpr uint32_t GCONF_reset = 0x00000000,
+														IHOLD_IRUN_reset = 0x00000000,
+														CHOPCONF_reset = 0x10410150,
+														PWMCONF_reset = 0x00050480;
+};
+struct TMC5160_chip : TMC2160_chip {
+	static constexpr bool begin_ramp = true;
+};
+struct TMC2208_chip {
+	typedef TMC2208_n::CHOPCONF_t CHOPCONF_t;
+	static constexpr bool global_scaler = false;
+	static constexpr bool begin_chopper = false;
+	static constexpr bool begin_ramp = false;
+	static constexpr uint32_t GCONF_begin = 0x000000C0; // pdn_disable, mstep_reg_select
+	static constexpr uint32_t GCONF_reset = 0x00000101,
+														IHOLD_IRUN_reset = 0x00010000,
+														CHOPCONF_reset = 0x10000053,
+														PWMCONF_reset = 0xC10D0024;
+};
+struct TMC2209_chip : TMC2208_chip {};
+
+/**
+ *  Driver front end without virtual calls. The chip and the bus are
+ *  template parameters, so helpers resolve at compile time and field
+ *  setters inline to a bitfield update and one bus call. Fields are
+ *  taken from the chip's register layout.
+ *
+ *  The bus provides write(address, value) and read(address). SPIDevice
+ *  and UARTDevice are the lean buses; a TMC2208Stepper or TMC2130Stepper
+ *  may serve as the bus to reuse its transport.
+ *
+ *  SPIChain chain(SPI);
+ *  SPIDevice bus(chain, CS_PIN);
+ *  TMCDriver<TMC2130_chip, SPIDevice> driver(bus, R_SENSE);
+ *  bus.begin(); driver.begin(); driver.toff(4);
+ */
+template<class Chip, class Bus>
+class TMCDriver {
+	public:
+		TMCDriver(Bus &b, float RS) : bus(b), Rsense(RS) {}
+
+		// Write the shadow registers, CHOPCONF last
+		void begin() {
+			GCONF_sr |= Chip::GCONF_begin;
+			if (Chip::begin_chopper) {
+				CHOPCONF_register.toff = 8;
+				CHOPCONF_register.tbl = 1;
+			}
+			push();
+			if (Chip::begin_ramp) {
+				write(XTARGET_address, 0);
+				write(XACTUAL_address, 0);
+			}
+		}
+		void push() {
+			write(GCONF_address, GCONF_sr);
+			write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr);
+			if (Chip::global_scaler) write(GLOBAL_SCALER_address, GLOBAL_SCALER_sr);
+			write(PWMCONF_address, PWMCONF_sr);
+			write(CHOPCONF_address, CHOPCONF_register.sr);
+		}
+
+		// Raw register access, bypasses the shadow registers
+		void write(uint8_t address, uint32_t value) { bus.Bus::write(address, value); }
+		uint32_t read(uint8_t address) { return bus.Bus::read(address); }
+
+		// Helper functions
+		uint16_t cs2rms(uint8_t CS) {
+			if (Chip::global_scaler) return TMC_current::scaled_rms(CS, Rsense, GLOBAL_SCALER_sr);
+			return TMC_current::rms(CS, Rsense, vsense());
+		}
+		void rms_current(uint16_t mA) {
+			uint8_t CS = 0;
+			if (Chip::global_scaler) {
+				CS = TMC_current::scaled_cs(mA, Rsense, GLOBAL_SCALER_sr);
+				write(GLOBAL_SCALER_address, GLOBAL_SCALER_sr);
+			}
+			else {
+				bool high_sense = false;
+				CS = TMC_current::cs(mA, Rsense, high_sense);
+				vsense(high_sense);
+			}
+			IHOLD_IRUN_register.irun = CS;
+			IHOLD_IRUN_register.ihold = CS*holdMultiplier;
+			write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr);
+		}
+		void rms_current(uint16_t mA, float mult) { holdMultiplier = mult; rms_current(mA); }
+		uint16_t rms_current() { return cs2rms(irun()); }
+		void hold_multiplier(float val) { holdMultiplier = val; }
+		float hold_multiplier() { return holdMultiplier; }
+
+		uint8_t test_connection() {
+			const uint32_t drv_status = DRV_STATUS();
+			return drv_status == 0xFFFFFFFF ? 1 : drv_status == 0 ? 2 : 0;
+		}
+
+		void microsteps(uint16_t ms) {
+			switch(ms) {
+				case 256: mres(0); break;
+				case 128: mres(1); break;
+				case  64: mres(2); break;
+				case  32: mres(3); break;
+				case  16: mres(4); break;
+				case   8: mres(5); break;
+				case   4: mres(6); break;
+				case   2: mres(7); break;
+				case   0: mres(8); break;
+				default: break;
+			}
+		}
+		uint16_t microsteps() {
+			const uint8_t res = mres();
+			return res < 8 ? 256 >> res : 0;
+		}
+		void blank_time(uint8_t value) {
+			switch (value) {
+				case 16: tbl(0b00); break;
+				case 24: tbl(0b01); break;
+				case 36: tbl(0b10); break;
+				case 54: tbl(0b11); break;
+			}
+		}
+		uint8_t blank_time() {
+			switch (tbl()) {
+				case 0b00: return 16;
+				case 0b01: return 24;
+				case 0b10: return 36;
+			}
+			return 54;
+		}
+		void hysteresis_end(int8_t value) { hend(value+3); }
+		int8_t hysteresis_end() { return hend()-3; }
+		void hysteresis_start(uint8_t value) { hstrt(value-1); }
+		uint8_t hysteresis_start() { return hstrt()+1; }
+
+		// W: GCONF
+		uint32_t GCONF() { return GCONF_sr; }
+		void GCONF(uint32_t input) { GCONF_sr = input; write(GCONF_address, GCONF_sr); }
+
+		// R+WC: GSTAT
+		uint8_t GSTAT() { return read(GSTAT_address); }
+		void GSTAT(uint8_t) { write(GSTAT_address, 0b111); }
+
+		// W: IHOLD_IRUN
+		uint32_t IHOLD_IRUN() { return IHOLD_IRUN_register.sr; }
+		void IHOLD_IRUN(uint32_t input) { IHOLD_IRUN_register.sr = input; write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr); }
+		void ihold(uint8_t B)				{ IHOLD_IRUN_register.ihold = B;			write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr); }
+		void irun(uint8_t B)				{ IHOLD_IRUN_register.irun = B;				write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr); }
+		void iholddelay(uint8_t B)	{ IHOLD_IRUN_register.iholddelay = B;	write(IHOLD_IRUN_address, IHOLD_IRUN_register.sr); }
+		uint8_t ihold()							{ return IHOLD_IRUN_register.ihold;			}
+		uint8_t irun()							{ return IHOLD_IRUN_register.irun;			}
+		uint8_t iholddelay()				{ return IHOLD_IRUN_register.iholddelay;	}
+
+		// RW: CHOPCONF
+		uint32_t CHOPCONF() { return CHOPCONF_register.sr; }
+		void CHOPCONF(uint32_t input) { CHOPCONF_register.sr = input; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void toff(uint8_t B)	{ CHOPCONF_register.toff = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void hstrt(uint8_t B)	{ CHOPCONF_register.hstrt = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void hend(uint8_t B)	{ CHOPCONF_register.hend = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void tbl(uint8_t B)	{ CHOPCONF_register.tbl = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void vsense(bool B)	{ CHOPCONF_register.vsense = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void mres(uint8_t B)	{ CHOPCONF_register.mres = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void intpol(bool B)	{ CHOPCONF_register.intpol = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		void dedge(bool B)	{ CHOPCONF_register.dedge = B; write(CHOPCONF_address, CHOPCONF_register.sr); }
+		uint8_t toff()	{ return CHOPCONF_register.toff; }
+		uint8_t hstrt()	{ return CHOPCONF_register.hstrt; }
+		uint8_t hend()	{ return CHOPCONF_register.hend; }
+		uint8_t tbl()	{ return CHOPCONF_register.tbl; }
+		bool vsense()	{ return CHOPCONF_register.vsense; }
+		uint8_t mres()	{ return CHOPCONF_register.mres; }
+		bool intpol()	{ return CHOPCONF_register.intpol; }
+		bool dedge()	{ return CHOPCONF_register.dedge; }
+
+		// W: PWMCONF
+		uint32_t PWMCONF() { return PWMCONF_sr; }
+		void PWMCONF(uint32_t input) { PWMCONF_sr = input; write(PWMCONF_address, PWMCONF_sr); }
+
+		// W: GLOBAL_SCALER, TMC2160 and TMC5160 only
+		uint8_t GLOBAL_SCALER() { return GLOBAL_SCALER_sr; }
+		void GLOBAL_SCALER(uint8_t input) { GLOBAL_SCALER_sr = input; write(GLOBAL_SCALER_address, GLOBAL_SCALER_sr); }
+
+		// R: TSTEP, MSCNT, DRV_STATUS
+		uint32_t TSTEP() { return read(TSTEP_address); }
+		uint16_t MSCNT() { return read(MSCNT_address); }
+		uint32_t DRV_STATUS() { return read(DRV_STATUS_address); }
+
+	protected:
+		static constexpr uint8_t	GCONF_address = 0x00,
+															GSTAT_address = 0x01,
+															GLOBAL_SCALER_address = 0x0B,
+															IHOLD_IRUN_address = 0x10,
+															TSTEP_address = 0x12,
+															XACTUAL_address = 0x21,
+															XTARGET_address = 0x2D,
+															MSCNT_address = 0x6A,
+															CHOPCONF_address = 0x6C,
+															DRV_STATUS_address = 0x6F,
+															PWMCONF_address = 0x70;
+
+		Bus &bus;
+		const float Rsense;
+		float holdMultiplier = 0.5;
+		uint32_t GCONF_sr = Chip::GCONF_reset;
+		IHOLD_IRUN_t IHOLD_IRUN_register{Chip::IHOLD_IRUN_reset};
+		typename Chip::CHOPCONF_t CHOPCONF_register{Chip::CHOPCONF_reset};
+		uint32_t PWMCONF_sr = Chip::PWMCONF_reset;
+		uint8_t GLOBAL_SCALER_sr = 0;
+};
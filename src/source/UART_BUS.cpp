@@ -0,0 +1,256 @@
+#include "TMCStepper.h"
+#include "UART_BUS.h"
+
+bool UARTBus::enqueue(const Request &request) {
+	if (count == queue_size) return false;
+
+	queue[(head + count) % queue_size] = request;
+	count++;
+	request.driver->queued++;
+	return true;
+}
+
+// Both return false when the queue is full and the request was dropped
+bool UARTBus::read(TMC2208Stepper &driver, uint8_t address, Callback callback) {
+	return enqueue({&driver, 0, callback, address, false});
+}
+
+bool UARTBus::write(TMC2208Stepper &driver, uint8_t address, uint32_t value) {
+	return enqueue({&driver, value, nullptr, address, true});
+}
+
+/**
+ *  Advances the transaction on the wire and starts the next request once
+ *  it is done. Completed reads are finished here, so callbacks always run
+ *  from the caller of poll(). Returns true while requests are in flight
+ *  or queued.
+ */
+bool UARTBus::poll() {
+	for (;;) {
+		if (active != nullptr) {
+			if (advance()) return true;
+			active = nullptr;
+		}
+		if (count == 0) return false;
+
+		const Request request = queue[head];
+		head = (head + 1) % queue_size;
+		count--;
+		request.driver->queued--;
+
+		active = request.driver;
+		async.address = request.address;
+		async.value = request.value;
+		async.callback = request.callback;
+		async.attempt = 0;
+		async.state = request.write ? ASYNC_WRITE_PENDING : ASYNC_READ_PENDING;
+	}
+}
+
+bool UARTBus::advance() {
+	switch (async.state) {
+		case ASYNC_WRITE_PENDING:
+			if (!active->line_ready(active->fast_writes)) break;
+			active->send_write(async.address, async.value);
+			async.state = active->fast_writes ? ASYNC_IDLE : ASYNC_WRITE;
+			break;
+		case ASYNC_WRITE:
+			if (line.ready()) async.state = ASYNC_IDLE;
+			break;
+		case ASYNC_READ_PENDING:
+			if (line.ready()) send_read();
+			break;
+		case ASYNC_READ:
+			while (async.state == ASYNC_READ && active->available() > 0) {
+				int16_t res = active->serial_read();
+				if (res < 0) break;
+				receive(res);
+			}
+			// receive() may complete the read from the RX interrupt meanwhile
+			noInterrupts();
+			if (async.state == ASYNC_READ && static_cast<int32_t>(micros() - async.deadline) > 0)
+				async.state = ASYNC_FAILED;
+			interrupts();
+			break;
+	}
+	if (async.state == ASYNC_DONE || async.state == ASYNC_FAILED)
+		finish_read(async.state == ASYNC_DONE);
+	return async.state != ASYNC_IDLE;
+}
+
+// Sends the read request of the active driver, the line is free
+void UARTBus::send_read() {
+	TMC2208Stepper &driver = *active;
+	uint8_t datagram[4];
+	TMC2208Stepper::read_datagram(datagram, driver.slave_address, async.address);
+
+	driver.preReadCommunication();
+	driver.discard_input();
+
+	// Set up before sending, the echo may reach receive() right away
+	async.echo = line.half_duplex ? line.echo_pending + sizeof(datagram) : 0;
+	line.echo_pending = 0;
+	async.skip = 0;
+	async.count = 0;
+	async.sync = 0;
+	async.crc = 0;
+	async.value = 0;
+	async.state = ASYNC_READ;
+
+	driver.serial_write(datagram, sizeof(datagram));
+	async.deadline = line.sent(sizeof(datagram)) + driver.reply_time();
+}
+
+// Only touches the read in progress and leaves the result to poll()
+void UARTBus::receive(uint8_t data) {
+	if (async.state != ASYNC_READ) return;
+
+	if (async.echo > 0) {
+		async.echo--;
+		return;
+	}
+
+	// The reply starts with sync, master address 0xFF and the register address
+	const uint32_t header = TMC2208Stepper::reply_header(async.address);
+	if (line.half_duplex && async.count < 3) {
+		// Follows the echo directly, so every header byte must match in place
+		if (data != static_cast<uint8_t>(header >> (16 - 8*async.count))) {
+			async.skip = 7 - async.count; // Rest of the frame, dropped before the retry
+			async.state = ASYNC_FAILED;
+			return;
+		}
+		async.crc = TMC2208Stepper::crc_update(async.crc, data);
+		async.count++;
+		return;
+	}
+	if (async.count == 0) {
+		async.sync = ((async.sync << 8) | data) & 0xFFFFFF;
+		if (async.sync != header) return;
+
+		async.crc = TMC2208Stepper::crc_update(TMC2208Stepper::crc_update(TMC2208Stepper::crc_update(0, TMC2208Stepper::TMC2208_SYNC), 0xFF), async.address);
+		async.count = 3;
+		return;
+	}
+
+	if (async.count++ < 7) {
+		async.crc = TMC2208Stepper::crc_update(async.crc, data);
+		async.value = (async.value << 8) | data;
+		return;
+	}
+
+	const uint8_t crc = TMC2208Stepper::crc_result(async.crc);
+	async.state = (crc == data && crc != 0) ? ASYNC_DONE : ASYNC_FAILED;
+}
+
+void UARTBus::finish_read(bool ok) {
+	TMC2208Stepper &driver = *active;
+	driver.postReadCommunication();
+	line.idle = micros();
+	if (async.skip) line.echo_pending = async.skip;
+
+	if (!ok && ++async.attempt < driver.max_retries) {
+		async.state = ASYNC_READ_PENDING; // Sent again once the line is free
+		return;
+	}
+
+	driver.CRCerror = !ok;
+	driver.result = ok ? async.value : 0;
+	async.state = ASYNC_IDLE;
+
+	const Callback callback = async.callback;
+	if (callback != nullptr)
+		callback(driver, async.address, driver.result, ok);
+}
+
+// Blocks until every queued request has completed
+void UARTBus::flush() {
+	while (poll()) {}
+}
+
+// Derives the frame gap from the line speed
+void UARTLine::baud_rate(uint32_t baud) {
+	if (baud == 0) return; // Unknown, keep the conservative defaults
+
+	byte_time_us = 10 * 1000000UL / baud + 1;
+	frame_gap_us = byte_time_us;
+}
+
+/**
+ *  Returns when the bytes just handed to the port will have left it.
+ *  Frames still waiting in the transmit buffer delay a reply, so reply
+ *  deadlines count from here. Without a known baud rate this is now.
+ */
+uint32_t UARTLine::sent(uint8_t bytes) {
+	const uint32_t now = micros();
+	if (static_cast<int32_t>(idle - now) < 0) idle = now;
+	idle += static_cast<uint32_t>(bytes) * byte_time_us;
+	return idle;
+}
+
+// True once the last datagram has left and the frame gap has passed
+bool UARTLine::ready() {
+	return static_cast<int32_t>(micros() - idle) >= static_cast<int32_t>(frame_gap_us);
+}
+
+void UARTDevice::baud_rate(uint32_t baud) {
+	// Same budget as TMC2208Stepper::reply_time() at the default SENDDELAY
+	const uint32_t wire_us = (8 + 8*10) * 1000000UL / baud;
+	const uint32_t timeout = 2*wire_us + 500;
+	reply_timeout_us = timeout > 0xFFFF ? 0xFFFF : timeout;
+	frame_gap_us = 10 * 1000000UL / baud + 1;
+}
+
+// Waits for the last datagram to leave the port, then for the frame gap
+void UARTDevice::wait_line() {
+	serial->flush();
+	if (sent) {
+		idle = micros();
+		sent = false;
+	}
+	while (static_cast<int32_t>(micros() - idle) < static_cast<int32_t>(frame_gap_us)) {}
+}
+
+void UARTDevice::write(uint8_t address, uint32_t value) {
+	uint8_t datagram[8];
+	TMC2208Stepper::write_datagram(datagram, slave_address, address, value);
+
+	wait_line();
+	serial->write(datagram, sizeof(datagram));
+	sent = true;
+}
+
+uint32_t UARTDevice::read(uint8_t address) {
+	uint8_t datagram[4];
+	TMC2208Stepper::read_datagram(datagram, slave_address, address);
+
+	for (uint8_t attempt = 0; attempt < max_retries; attempt++) {
+		wait_line();
+		while (serial->available() > 0) serial->read(); // Echo of earlier writes
+		serial->write(datagram, sizeof(datagram));
+		serial->flush();
+
+		// Reply: sync, master address 0xFF, register, 4 data bytes, CRC
+		uint64_t reply = 0;
+		uint8_t received = 0;
+		uint8_t echo = half_duplex_mode ? sizeof(datagram) : 0;
+		const uint32_t start = micros();
+		while (received < 8 && static_cast<int32_t>(micros() - start) <= reply_timeout_us) {
+			const int16_t res = serial->read();
+			if (res < 0) continue;
+			if (echo > 0) echo--;
+			else {
+				reply = (reply << 8) | (res & 0xFF);
+				received++;
+			}
+		}
+		idle = micros();
+
+		if (received < 8 || (reply >> 40) != TMC2208Stepper::reply_header(address) || !TMC2208Stepper::reply_valid(reply))
+			continue;
+
+		CRCerror = false;
+		return reply >> 8;
+	}
+	CRCerror = true;
+	return 0;
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include <Arduino.h>
+#include <Stream.h>
+#elif defined(bcm2835)
+#include "source/rpi_bcm2835.h"
+#include "source/bcm2835_stream.h"
+#endif
+
+class TMC2208Stepper;
+
+// State and timing of one wire. Drivers on a UARTBus share the one of the bus.
+struct UARTLine {
+	uint32_t idle = 0;					// End of the last transmission
+	uint16_t echo_pending = 0;	// Own bytes not yet received back
+	uint16_t byte_time_us = 0;	// 0 while the baud rate is unknown
+	uint16_t frame_gap_us = 2000;
+	bool half_duplex = false;		// TX and RX joined, transmitted bytes are echoed
+
+	void baud_rate(uint32_t baud);
+	uint32_t sent(uint8_t bytes);
+	bool ready();
+};
+
+/**
+ *  One UART shared by one or several TMC2209 slave addresses.
+ *  Queues the non-blocking transactions of all attached drivers and runs
+ *  them back to back. Only one read is on the wire at a time, so each
+ *  reply is handed to the driver that sent the request. The transaction
+ *  state lives here rather than in every driver.
+ *
+ *  Requests go out from poll() once the line is free, poll() never waits.
+ *  Without baud_rate() a datagram is taken to have left the port one frame
+ *  gap after it was handed over.
+ */
+class UARTBus {
+	public:
+		typedef void (*Callback)(TMC2208Stepper &driver, uint8_t address, uint32_t value, bool ok);
+
+		UARTBus(Stream &port) : serial(&port) {}
+		// Drivers keep a pointer to the bus and its line state
+		UARTBus(const UARTBus&) = delete;
+		UARTBus& operator=(const UARTBus&) = delete;
+
+		bool read(TMC2208Stepper &driver, uint8_t address, Callback callback = nullptr);
+		bool write(TMC2208Stepper &driver, uint8_t address, uint32_t value);
+		bool poll();
+		void flush();
+		// Safe to call from the RX interrupt with each received byte
+		void receive(uint8_t data);
+		// Line timing of all attached drivers, see TMC2208Stepper::baud_rate()
+		void baud_rate(uint32_t baud) { line.baud_rate(baud); }
+		void frame_gap(uint16_t us) { line.frame_gap_us = us; }
+		bool busy() { return active != nullptr || count > 0; }
+		uint8_t pending() { return count; }
+
+	protected:
+		friend class TMC2208Stepper;
+
+		struct Request {
+			TMC2208Stepper *driver;
+			uint32_t value;
+			Callback callback;
+			uint8_t address;
+			bool write;
+		};
+		bool enqueue(const Request &request);
+		bool advance();
+		void send_read();
+		void finish_read(bool ok);
+
+		static constexpr uint8_t queue_size = 8;
+		Request queue[queue_size];
+		uint8_t head = 0;
+		uint8_t count = 0;
+		TMC2208Stepper *active = nullptr;
+		Stream * const serial;
+		UARTLine line;
+
+		// Transaction of the active driver. Shared with receive() in the RX
+		// interrupt, which only writes while the state is ASYNC_READ and ends
+		// that state with DONE or FAILED.
+		enum : uint8_t { ASYNC_IDLE, ASYNC_WRITE_PENDING, ASYNC_WRITE, ASYNC_READ_PENDING, ASYNC_READ, ASYNC_DONE, ASYNC_FAILED };
+		volatile struct {
+			uint8_t state = ASYNC_IDLE;
+			uint8_t address = 0;
+			uint8_t attempt = 0;
+			uint8_t count = 0; // Reply bytes received after sync
+			uint16_t echo = 0; // Own bytes still to be dropped
+			uint8_t skip = 0; // Rest of a broken reply, dropped before the retry
+			uint8_t crc = 0;
+			uint32_t sync = 0;
+			uint32_t value = 0; // Also the value of a pending write
+			uint32_t deadline = 0; // Of the reply
+			Callback callback = nullptr;
+		} async;
+};
+
+/**
+ *  Register access to one driver on a hardware UART, without shadow
+ *  registers or virtual calls. Serves as the bus of the TMCDriver front end.
+ *
+ *  UARTDevice bus(Serial1, 0);
+ *  TMCDriver<TMC2209_chip, UARTDevice> driver(bus, R_SENSE);
+ *  Serial1.begin(115200); bus.baud_rate(115200); driver.begin();
+ */
+class UARTDevice {
+	public:
+		UARTDevice(Stream &port, uint8_t addr = 0) : serial(&port), slave_address(addr) {}
+
+		// Derives the frame gap and reply timeout, defaults are conservative
+		void baud_rate(uint32_t baud);
+		// TX and RX on one wire, each request comes back as echo
+		void half_duplex(bool enable) { half_duplex_mode = enable; }
+		// Attempts per read, as TMC2208Stepper::retries()
+		void retries(uint8_t attempts) { max_retries = attempts ? attempts : 1; }
+
+		void write(uint8_t address, uint32_t value);
+		uint32_t read(uint8_t address);
+		// True if the last read got no valid reply
+		bool read_failed() { return CRCerror; }
+
+	protected:
+		void wait_line();
+
+		Stream * const serial;
+		const uint8_t slave_address;
+		uint8_t max_retries = 2;
+		uint16_t frame_gap_us = 2000;
+		uint16_t reply_timeout_us = 7000;
+		uint32_t idle = 0;
+		bool sent = false;
+		bool half_duplex_mode = false;
+		bool CRCerror = false;
+};
@@ -23,6 +23,11 @@ uint8_t SPIClass::transfer(uint8_t value)
 	return bcm2835_spi_transfer(value);
 }
 
+void SPIClass::transfer(void *buf, size_t count)
+{
+	bcm2835_spi_transfern(static_cast<char*>(buf), count);
+}
+
 SPISettings::SPISettings(uint32_t s, bcm2835SPIBitOrder o, bcm2835SPIMode m)
 {
 	speed = s;
@@ -20,6 +20,7 @@ public:
 	void beginTransaction(SPISettings settings);
 	void endTransaction();
 	uint8_t transfer(uint8_t);
+	void transfer(void *buf, size_t count);
 };
 
 struct SPISettings
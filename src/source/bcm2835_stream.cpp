@@ -1,15 +1,25 @@
 #if defined(bcm2835)
-#include <termios.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/ioctl.h>
-#include <sys/types.h>
-#include <sys/stat.h>
+#include <asm/termbits.h>
 #include "bcm2835_stream.h"
 
+static uint64_t monotonic_us()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
 uint32_t millis()
 {
-	struct timeval now;
-	gettimeofday(&now, NULL);
-	return (uint32_t) ( now.tv_usec / 1000 );
+	return (uint32_t) ( monotonic_us() / 1000 );
+}
+
+uint32_t micros()
+{
+	return (uint32_t) monotonic_us();
 }
 
 Stream::Stream(const char* port)
@@ -19,36 +29,59 @@ Stream::Stream(const char* port)
 
 void Stream::begin(unsigned long baud, int flags)
 {
-	struct termios options;
+	struct termios2 options;
 
 	fd = open(port, flags);
 	if (fd == -1) {
 		printf("[ERROR] UART open(%s)\n", port);
 		return;
 	}
-	fcntl(fd, F_SETFL, O_RDWR);
+	// Blocking writes even if opened with O_NONBLOCK, reads are checked with poll()
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
 
-	tcgetattr(fd, &options);
-	options.c_cflag = CS8 | CLOCAL | CREAD | CBAUDEX;
-	options.c_cflag &= ~CBAUD;
+	// Raw 8N1. termios2 with BOTHER takes any rate, not only the Bxxx constants.
+	ioctl(fd, TCGETS2, &options);
+	options.c_cflag = CS8 | CLOCAL | CREAD | BOTHER;
 	options.c_iflag = IGNPAR;
-	options.c_oflag = baud;
-	options.c_lflag = baud;
-	tcflush(fd, TCIFLUSH);
-	tcsetattr(fd, TCSANOW, &options);
+	options.c_oflag = 0;
+	options.c_lflag = 0;
+	options.c_cc[VMIN] = 0;
+	options.c_cc[VTIME] = 0;
+	options.c_ispeed = baud;
+	options.c_ospeed = baud;
+	if (ioctl(fd, TCSETS2, &options) == -1) {
+		printf("[ERROR] UART baud rate %lu on %s\n", baud, port);
+	}
+	ioctl(fd, TCFLSH, TCIFLUSH);
+	rx_head = rx_tail = 0;
 }
 
 void Stream::end()
 {
 	::close(fd);
+	fd = -1;
+}
+
+// Moves whatever the driver has received into the buffer, without blocking
+size_t Stream::fill()
+{
+	struct pollfd pfd = { fd, POLLIN, 0 };
+
+	rx_head = rx_tail = 0;
+	if (fd == -1 || poll(&pfd, 1, 0) <= 0)
+		return 0;
+
+	ssize_t count = ::read(fd, rx_buffer, sizeof(rx_buffer));
+	if (count > 0)
+		rx_tail = count;
+	return rx_tail;
 }
 
 int Stream::available()
 {
-	int result;
-	if (ioctl(fd, FIONREAD, &result) == -1)
-		return -1;
-	return result;
+	if (rx_head == rx_tail)
+		fill();
+	return rx_tail - rx_head;
 }
 
 uint8_t Stream::write(const uint8_t data)
@@ -56,12 +89,17 @@ uint8_t Stream::write(const uint8_t data)
     return (uint8_t)::write(fd, &data, 1);
 }
 
-uint8_t Stream::read()
+size_t Stream::write(const uint8_t *buffer, size_t size)
+{
+	ssize_t written = ::write(fd, buffer, size);
+	return written < 0 ? 0 : written;
+}
+
+int Stream::read()
 {
-	uint8_t data = -1;
-	if (::read(fd, &data, 1) == -1)
+	if (rx_head == rx_tail && fill() == 0)
 		return -1;
-	return data;
+	return rx_buffer[rx_head++];
 }
 
 Stream Serial("/dev/serial0");
@@ -8,10 +8,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
-#include <sys/time.h>
 #include <bcm2835.h>
 
+// Monotonic, wrap like their Arduino counterparts
 uint32_t millis();
+uint32_t micros();
 
 class Stream
 {
@@ -22,10 +23,16 @@ public:
 	void end();
 	int available(void);
 	uint8_t write(const uint8_t data);
-	uint8_t read();
+	size_t write(const uint8_t *buffer, size_t size);
+	int read();
 private:
-	int fd;                    /* Filedeskriptor */
+	size_t fill();
+
+	int fd = -1;                    /* Filedeskriptor */
 	const char* port;
+	uint8_t rx_buffer[256];
+	uint16_t rx_head = 0;
+	uint16_t rx_tail = 0;
 };
 
 extern Stream Serial;
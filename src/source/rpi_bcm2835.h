@@ -10,3 +10,7 @@
 #define pinMode(PIN, MODE) bcm2835_gpio_fsel(PIN, MODE); if (MODE == (uint8_t)BCM2835_GPIO_PUD_UP || MODE == (uint8_t)BCM2835_GPIO_PUD_DOWN) bcm2835_gpio_set_pud(PIN, MODE)
 #define digitalWrite(PIN, MODE) bcm2835_gpio_write(PIN, MODE)
 #define digitalRead(PIN)  bcm2835_gpio_lev(PIN)
+#define delay(MS) bcm2835_delay(MS)
+#define delayMicroseconds(US) bcm2835_delayMicroseconds(US)
+#define noInterrupts()
+#define interrupts()